@@ -3,6 +3,7 @@
 ************************************************/
  #include "forceManager.h"
  #include "utilities.h"
+ #include "pairTable.h"
 
 using namespace PSim;
 using namespace std;
@@ -20,20 +21,33 @@ class AOPotential : public PSim::IForce
 private:
 
 		//Variables vital to the force.
-		double wellDepth;
+		pairTable wellDepth;
 		double kT;
-		double cutOff;
+		pairTable cutOff;
 		double dt;
 
-		//Secondary variables.
-		double coEff1;
-		double coEff2;
+		//Secondary variables for each species pair.
+		pairTable cutOffSquared;
+		pairTable coEff1;
+		pairTable coEff2;
 
 		//Potential variables.
 		double a1;
 		double a2;
 		double a3;
 
+		//Use the tiled traversal.
+		bool tiled;
+
+		/**
+		 * @brief The AO force between a pair.
+		 * @param r The distance between the pair.
+		 * @param rSquared The squared distance between the pair.
+		 * @param c1,c2 The force coefficients of the pair.
+		 * @return Positive for attractive; negative for repulsive.
+		 */
+		double pairForce(double r, double rSquared, double c1, double c2);
+
 	public:
 
 		/**
@@ -61,14 +75,23 @@ private:
 		 * @return True for time dependent. False otherwise. 
 		 */
 		bool isTimeDependent() { return false; }
+		/**
+		 * @brief Flag for the tiled traversal.
+		 */
+		bool isTiled() { return tiled; }
+		/**
+		 * @brief Get the force on every particle in a home cell from a staged tile.
+		 */
+		void getTileAcceleration(int hash, PSim::cellTile* tile, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
 		/**
 		 * @brief Checks for particle interation between the index particle and all particles in the provided cell.
 		 * @param boxSize The size of the system.
 		 * @param time The current system time.
 		 * @param index The particle to find the force on.
+		 * @param species The species of the index particle.
 		 * @param itemCell The cell to check for interactions in.
 		 */
-		type3<double> iterCells(int index, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+		type3<double> iterCells(int index, int species, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state);
 
 		void quench(systemState* state) {};
 };
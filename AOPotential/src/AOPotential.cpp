@@ -24,10 +24,6 @@ SOFTWARE.*/
 
 AOPotential::~AOPotential()
 {
-	delete &kT;
-	delete &cutOff;
-	delete &coEff1;
-	delete &coEff2;
 }
 
 AOPotential::AOPotential(config* cfg)
@@ -35,93 +31,126 @@ AOPotential::AOPotential(config* cfg)
 	//Sets the name
 	name = "AOPotential";
 
+	//Number of particle species.
+	int nSpecies = cfg->getParam<int>("nSpecies", 1);
+	nSpecies = (nSpecies < 1) ? 1 : nSpecies;
+
 	//Set vital variables.
 
-	wellDepth = cfg->getParam<double>("wellDepth", 0.261);
+	wellDepth = pairTable(cfg, "wellDepth", 0.261, nSpecies);
 	kT = cfg->getParam<double>("kT",1.0);
 
 	//Sets the integration time step.
 	dt = cfg->getParam<double>("timeStep",0.001);
 
 	//Get force range cutoff.
-	cutOff = cfg->getParam<double>("cutOff",1.1);
-
-	//Create secondary variables.
-	a1=-kT*wellDepth*(cutOff/(cutOff-1.0))*(cutOff/(cutOff-1.0))*(cutOff/(cutOff-1.0));
-	a2=-3.0/(2.0*cutOff);
-	a3=1.0/(2.0*cutOff*cutOff*cutOff);
+	cutOff = pairTable(cfg, "cutOff", 1.1, nSpecies);
+
+	//Create secondary variables for each species pair.
+	cutOffSquared = pairTable(nSpecies, 0.0);
+	coEff1 = pairTable(nSpecies, 0.0);
+	coEff2 = pairTable(nSpecies, 0.0);
+	for (int i=0; i<nSpecies; i++) {
+		for (int j=i; j<nSpecies; j++) {
+			double cut = cutOff(i,j);
+			a1=-kT*wellDepth(i,j)*(cut/(cut-1.0))*(cut/(cut-1.0))*(cut/(cut-1.0));
+			a2=-3.0/(2.0*cut);
+			a3=1.0/(2.0*cut*cut*cut);
+
+			cutOffSquared.set(i, j, cut*cut);
+			coEff1.set(i, j, -a1*a2);
+			coEff2.set(i, j, -3.0*a1*a3);
+		}
+	}
 
-	coEff1 = -a1*a2;
-	coEff2 = -3.0*a1*a3;
+	//Stage each home cell and its neighbors once.
+	tiled = cfg->getParam<int>("tiledForce",1);
 
 	PSim::util::writeTerminal("---AO Potential successfully added.\n\n", PSim::Colour::Cyan);
 
 }
 
-type3<double> AOPotential::iterCells(int index, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state)
+double AOPotential::pairForce(double r, double rSquared, double c1, double c2)
 {
-	int start = get<0>((*cellStartEnd)[hash]);
+	//Math
+	double rInv=1.0/r;
+	double r_36=PSim::util::powFixed<36>(rInv);
+	double r_38=r_36/rSquared;
+	double fNet=36.0*r_38+c1*rInv+c2*r;
+
+	//We need to switch the sign of the force.
+	//Positive for attractive; negative for repulsive.
+	fNet=-fNet;
+
+	//If the force is infinite then there are worse problems.
+	if (std::isnan(fNet))
+	{
+		//This error should only get thrown in the case of numerical instability.
+		PSim::error::throwInfiniteForce();
+	}
+	return fNet;
+}
 
+type3<double> AOPotential::iterCells(int index, int species, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state)
+{
 	type3<double> cellForce = type3<double>();
-
-	if (start != 0xffffffff) {
-		int end = get<1>((*cellStartEnd)[hash]);
-		for (int i=start; i<end; i++) {
-			if (i != index) {
-				int indexOffset = 4*index;
-				int iOffset = 4*i;
-
-				double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
-																	sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
-																	state->boxSize);
-
-				//If the particles are in the potential well.
-				double rCutSquared = cutOff*cutOff;
-				if (rSquared < rCutSquared)
-				{
-					double r = sqrt(rSquared);
-					//If the particles overlap there are problems.
-					double size = (sortedParticles[indexOffset+3] + sortedParticles[iOffset+3]);
-					if(r< (0.8*size) )
-					{
-						PSim::error::throwParticleOverlapError(hash, i, index, r);
-					}
-
-					//-------------------------------------
-					//-----------FORCE CALCULATION---------
-					//-------------------------------------
-
-					//Math
-					double rInv=1.0/r;
-					double r_36=pow(rInv,36);
-					double r_38=r_36/rSquared;
-					double fNet=36.0*r_38+coEff1*rInv+coEff2*r;
-
-					//We need to switch the sign of the force.
-					//Positive for attractive; negative for repulsive.
-					fNet=-fNet;
-
-					//If the force is infinite then there are worse problems.
-					if (std::isnan(fNet))
+	int nSpecies = state->nSpecies;
+	int nRuns = state->runsPerCell();
+
+	//Particles in a cell are sorted by species. Hoist the pair constants for each run.
+	//Frozen particles follow in a second block of runs.
+	for (int k=0; k<nRuns; k++) {
+		int run = state->runIndex(hash, k);
+		int s = k % nSpecies;
+		int start = get<0>((*cellStartEnd)[run]);
+
+		if (start != emptyCell) {
+			int end = get<1>((*cellStartEnd)[run]);
+			double rCutSquared = cutOffSquared(species, s);
+			double c1 = coEff1(species, s);
+			double c2 = coEff2(species, s);
+
+			for (int i=start; i<end; i++) {
+				if (i != index) {
+					int indexOffset = 4*index;
+					int iOffset = 4*i;
+
+					double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
+																		sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
+																		state->boxSize);
+
+					//If the particles are in the potential well.
+					if (rSquared < rCutSquared)
 					{
-						//This error should only get thrown in the case of numerical instability.
-						PSim::error::throwInfiniteForce();
+						double r = sqrt(rSquared);
+						//If the particles overlap there are problems.
+						double size = (sortedParticles[indexOffset+3] + sortedParticles[iOffset+3]);
+						if(r< (0.8*size) )
+						{
+							PSim::error::throwParticleOverlapError(hash, i, index, r);
+						}
+
+						//-------------------------------------
+						//-----------FORCE CALCULATION---------
+						//-------------------------------------
+
+						double fNet = pairForce(r, rSquared, c1, c2);
+
+						//-------------------------------------
+						//------NORMALIZATION AND SETTING------
+						//-------------------------------------
+
+						//Normalize the force.
+						double unitVec[3] {0.0,0.0,0.0};
+						PSim::util::unitVectorAdv(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
+															sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
+															unitVec, r, state->boxSize);
+
+						//Updates the acceleration.;
+						cellForce.x += fNet*unitVec[0];
+						cellForce.y += fNet*unitVec[1];
+						cellForce.z += fNet*unitVec[2];
 					}
-
-					//-------------------------------------
-					//------NORMALIZATION AND SETTING------
-					//-------------------------------------
-
-					//Normalize the force.
-					double unitVec[3] {0.0,0.0,0.0};
-					PSim::util::unitVectorAdv(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
-														sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
-														unitVec, r, state->boxSize);
-
-					//Updates the acceleration.;
-					cellForce.x += fNet*unitVec[0];
-					cellForce.y += fNet*unitVec[1];
-					cellForce.z += fNet*unitVec[2];
 				}
 			}
 		}
@@ -139,6 +168,7 @@ void AOPotential::getAcceleration(int index, double* sortedParticles, double* pa
 	int scale = state->cellScale;
 	int cellScaleSq = scale*scale;
 	int realIndex = 3*get<1>((*particleHashIndex)[index]);
+	int species = get<0>((*particleHashIndex)[index]) % state->nSpecies;
 
 	cell.x = floor(sortedParticles[indexOffset] / state->cellSize);
 	cell.y = floor(sortedParticles[indexOffset+1] / state->cellSize);
@@ -161,7 +191,7 @@ void AOPotential::getAcceleration(int index, double* sortedParticles, double* pa
 
 				hash = cRef.x + (scale * cRef.y) + (cellScaleSq * cRef.z);
 
-				type3<double> result = iterCells(index, hash, sortedParticles, cellStartEnd, state);
+				type3<double> result = iterCells(index, species, hash, sortedParticles, cellStartEnd, state);
 				netForce[0] += result.x;
 				netForce[1] += result.y;
 				netForce[2] += result.z;
@@ -173,3 +203,85 @@ void AOPotential::getAcceleration(int index, double* sortedParticles, double* pa
 	particleForce[realIndex+1] = netForce[1];
 	particleForce[realIndex+2] = netForce[2];
 }
+
+void AOPotential::getTileAcceleration(int hash, PSim::cellTile* tile, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state)
+{
+	if (!tile->load(hash, sortedParticles, cellStartEnd, state)) {
+		return;
+	}
+	const double* tx = tile->x;
+	const double* ty = tile->y;
+	const double* tz = tile->z;
+	const double* tr = tile->r;
+	const int* tIndex = tile->index;
+	int nRuns = tile->runs.size();
+
+	for (unsigned int h=0; h<tile->home.size(); h++) {
+		int species = tile->home[h].species;
+
+		for (int index=tile->home[h].begin; index<tile->home[h].end; index++) {
+			int indexOffset = 4*index;
+			double xi = sortedParticles[indexOffset];
+			double yi = sortedParticles[indexOffset+1];
+			double zi = sortedParticles[indexOffset+2];
+			double ri = sortedParticles[indexOffset+3];
+			double netForce[3] = {0.0,0.0,0.0};
+
+			//Sum each neighbor cell on its own, as in the per particle traversal.
+			type3<double> cellForce = type3<double>();
+			int cell = -1;
+
+			for (int k=0; k<nRuns; k++) {
+				const PSim::cellTile::tileRun& run = tile->runs[k];
+				if (run.cell != cell) {
+					netForce[0] += cellForce.x;
+					netForce[1] += cellForce.y;
+					netForce[2] += cellForce.z;
+					cellForce = type3<double>();
+					cell = run.cell;
+				}
+
+				double rCutSquared = cutOffSquared(species, run.species);
+				double c1 = coEff1(species, run.species);
+				double c2 = coEff2(species, run.species);
+
+				for (int j=run.begin; j<run.end; j++) {
+					if (tIndex[j] != index) {
+						double rSquared = PSim::util::pbcDist(xi, yi, zi, tx[j], ty[j], tz[j], state->boxSize);
+
+						//If the particles are in the potential well.
+						if (rSquared < rCutSquared)
+						{
+							double r = sqrt(rSquared);
+							//If the particles overlap there are problems.
+							double size = (ri + tr[j]);
+							if(r< (0.8*size) )
+							{
+								PSim::error::throwParticleOverlapError(run.hash, tIndex[j], index, r);
+							}
+
+							double fNet = pairForce(r, rSquared, c1, c2);
+
+							//Normalize the force.
+							double unitVec[3] {0.0,0.0,0.0};
+							PSim::util::unitVectorAdv(xi, yi, zi, tx[j], ty[j], tz[j], unitVec, r, state->boxSize);
+
+							//Updates the acceleration.
+							cellForce.x += fNet*unitVec[0];
+							cellForce.y += fNet*unitVec[1];
+							cellForce.z += fNet*unitVec[2];
+						}
+					}
+				}
+			}
+			netForce[0] += cellForce.x;
+			netForce[1] += cellForce.y;
+			netForce[2] += cellForce.z;
+
+			int realIndex = 3*get<1>((*particleHashIndex)[index]);
+			particleForce[realIndex] = netForce[0];
+			particleForce[realIndex+1] = netForce[1];
+			particleForce[realIndex+2] = netForce[2];
+		}
+	}
+}
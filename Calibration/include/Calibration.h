@@ -3,6 +3,7 @@
 ************************************************/
  #include "forceManager.h"
  #include "utilities.h"
+ #include "pairTable.h"
 
 using namespace PSim;
 using namespace std;
@@ -20,7 +21,7 @@ class Calibration : public PSim::IForce
 private:
 
 		//Variables vital to the force.
-		double cutOff;
+		pairTable cutOffSquared;
 
 	public:
 
@@ -54,9 +55,10 @@ private:
 		 * @param boxSize The size of the system.
 		 * @param time The current system time.
 		 * @param index The particle to find the force on.
+		 * @param species The species of the index particle.
 		 * @param itemCell The cell to check for interactions in.
 		 */
-		type3<double> iterCells(int index, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+		type3<double> iterCells(int index, int species, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state);
 
 		void quench(systemState* state) {};
 };
@@ -24,7 +24,6 @@ SOFTWARE.*/
 
 Calibration::~Calibration()
 {
-	delete &cutOff;
 }
 
 Calibration::Calibration(config* cfg)
@@ -32,68 +31,87 @@ Calibration::Calibration(config* cfg)
 	//Sets the name
 	name = "Calibration";
 
-	//Get force range cutoff.
-	cutOff = cfg->getParam<double>("cutOff",1.1);
+	//Number of particle species.
+	int nSpecies = cfg->getParam<int>("nSpecies", 1);
+	nSpecies = (nSpecies < 1) ? 1 : nSpecies;
+
+	//Get force range cutoff of each species pair.
+	pairTable cutOff = pairTable(cfg, "cutOff", 1.1, nSpecies);
+	cutOffSquared = pairTable(nSpecies, 0.0);
+	for (int i=0; i<nSpecies; i++) {
+		for (int j=i; j<nSpecies; j++) {
+			cutOffSquared.set(i, j, cutOff(i,j)*cutOff(i,j));
+		}
+	}
 
 	PSim::util::writeTerminal("---Calibration Force successfully added.\n\n", PSim::Colour::Cyan);
 }
 
-type3<double> Calibration::iterCells(int index, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state)
+type3<double> Calibration::iterCells(int index, int species, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state)
 {
-	int start = get<0>((*cellStartEnd)[hash]);
-
 	type3<double> cellForce = type3<double>();
-
-	if (start != 0xffffffff) {
-		int end = get<1>((*cellStartEnd)[hash]);
-		for (int i=start; i<end; i++) {
-			if (i != index) {
-				int indexOffset = 4*index;
-				int iOffset = 4*i;
-
-				double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
-																	sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
-																	state->boxSize);
-
-				//If the particles are in the potential well.
-				double rCutSquared = cutOff*cutOff;
-				if (rSquared < rCutSquared)
-				{
-					double r = sqrt(rSquared);
-					//If the particles overlap there are problems.
-					double size = (sortedParticles[indexOffset+3] + sortedParticles[iOffset+3]);
-					if(r< (0.8*size) )
+	int nSpecies = state->nSpecies;
+	int nRuns = state->runsPerCell();
+
+	//Particles in a cell are sorted by species. Hoist the pair constants for each run.
+	//Frozen particles follow in a second block of runs.
+	for (int k=0; k<nRuns; k++) {
+		int run = state->runIndex(hash, k);
+		int s = k % nSpecies;
+		int start = get<0>((*cellStartEnd)[run]);
+
+		if (start != emptyCell) {
+			int end = get<1>((*cellStartEnd)[run]);
+			double rCutSquared = cutOffSquared(species, s);
+
+			for (int i=start; i<end; i++) {
+				if (i != index) {
+					int indexOffset = 4*index;
+					int iOffset = 4*i;
+
+					double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
+																		sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
+																		state->boxSize);
+
+					//If the particles are in the potential well.
+					if (rSquared < rCutSquared)
 					{
-						PSim::error::throwParticleOverlapError(hash, i, index, r);
+						double r = sqrt(rSquared);
+						//If the particles overlap there are problems.
+						double size = (sortedParticles[indexOffset+3] + sortedParticles[iOffset+3]);
+						if(r< (0.8*size) )
+						{
+							PSim::error::throwParticleOverlapError(hash, i, index, r);
+						}
+
+						//-------------------------------------
+						//-----------FORCE CALCULATION---------
+						//-------------------------------------
+
+						//Math
+						double rInv=1.0/r;
+						double r_37=36.0*PSim::util::powFixed<37>(rInv);
+						double fNet=r_37;
+
+						//We need to switch the sign of the force.
+						//Positive for attractive; negative for repulsive.
+						fNet=-fNet;
+
+						//-------------------------------------
+						//------NORMALIZATION AND SETTING------
+						//-------------------------------------
+
+						//Normalize the force.
+						double unitVec[3] {0.0,0.0,0.0};
+						PSim::util::unitVectorAdv(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
+															sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
+															unitVec, r, state->boxSize);
+
+						//Updates the acceleration.;
+						cellForce.x += fNet*unitVec[0];
+						cellForce.y += fNet*unitVec[1];
+						cellForce.z += fNet*unitVec[2];
 					}
-
-					//-------------------------------------
-					//-----------FORCE CALCULATION---------
-					//-------------------------------------
-
-					//Math
-					double rInv=1.0/r;
-					double r_37=36.0*pow(rInv,37);
-					double fNet=r_37;
-
-					//We need to switch the sign of the force.
-					//Positive for attractive; negative for repulsive.
-					fNet=-fNet;
-
-					//-------------------------------------
-					//------NORMALIZATION AND SETTING------
-					//-------------------------------------
-
-					//Normalize the force.
-					double unitVec[3] {0.0,0.0,0.0};
-					PSim::util::unitVectorAdv(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
-														sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
-														unitVec, r, state->boxSize);
-
-					//Updates the acceleration.;
-					cellForce.x += fNet*unitVec[0];
-					cellForce.y += fNet*unitVec[1];
-					cellForce.z += fNet*unitVec[2];
 				}
 			}
 		}
@@ -111,6 +129,7 @@ void Calibration::getAcceleration(int index, double* sortedParticles, double* pa
 	int scale = state->cellScale;
 	int cellScaleSq = scale*scale;
 	int realIndex = 3*get<1>((*particleHashIndex)[index]);
+	int species = get<0>((*particleHashIndex)[index]) % state->nSpecies;
 
 	cell.x = floor(sortedParticles[indexOffset] / state->cellSize);
 	cell.y = floor(sortedParticles[indexOffset+1] / state->cellSize);
@@ -133,7 +152,7 @@ void Calibration::getAcceleration(int index, double* sortedParticles, double* pa
 
 				hash = cRef.x + (scale * cRef.y) + (cellScaleSq * cRef.z);
 
-				type3<double> result = iterCells(index, hash, sortedParticles, cellStartEnd, state);
+				type3<double> result = iterCells(index, species, hash, sortedParticles, cellStartEnd, state);
 				netForce[0] += result.x;
 				netForce[1] += result.y;
 				netForce[2] += result.z;
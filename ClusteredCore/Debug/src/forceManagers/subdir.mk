@@ -4,13 +4,22 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/forceManagers/defaultForceManager.cpp 
+../src/forceManagers/cellScheduler.cpp \
+../src/forceManagers/cellTile.cpp \
+../src/forceManagers/defaultForceManager.cpp \
+../src/forceManagers/pmeSolver.cpp 
 
 OBJS += \
-./src/forceManagers/defaultForceManager.o 
+./src/forceManagers/cellScheduler.o \
+./src/forceManagers/cellTile.o \
+./src/forceManagers/defaultForceManager.o \
+./src/forceManagers/pmeSolver.o 
 
 CPP_DEPS += \
-./src/forceManagers/defaultForceManager.d 
+./src/forceManagers/cellScheduler.d \
+./src/forceManagers/cellTile.d \
+./src/forceManagers/defaultForceManager.d \
+./src/forceManagers/pmeSolver.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
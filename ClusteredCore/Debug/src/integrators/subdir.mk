@@ -4,13 +4,22 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/integrators/brownianIntegrator.cpp 
+../src/integrators/baoabIntegrator.cpp \
+../src/integrators/brownianIntegrator.cpp \
+../src/integrators/ermakIntegrator.cpp \
+../src/integrators/hydroIntegrator.cpp 
 
 OBJS += \
-./src/integrators/brownianIntegrator.o 
+./src/integrators/baoabIntegrator.o \
+./src/integrators/brownianIntegrator.o \
+./src/integrators/ermakIntegrator.o \
+./src/integrators/hydroIntegrator.o 
 
 CPP_DEPS += \
-./src/integrators/brownianIntegrator.d 
+./src/integrators/baoabIntegrator.d \
+./src/integrators/brownianIntegrator.d \
+./src/integrators/ermakIntegrator.d \
+./src/integrators/hydroIntegrator.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -5,21 +5,27 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../src/system/system.cpp \
+../src/system/systemAutotune.cpp \
 ../src/system/systemHandling.cpp \
 ../src/system/systemInit.cpp \
-../src/system/systemRecovery.cpp 
+../src/system/systemRecovery.cpp \
+../src/system/systemStepControl.cpp 
 
 OBJS += \
 ./src/system/system.o \
+./src/system/systemAutotune.o \
 ./src/system/systemHandling.o \
 ./src/system/systemInit.o \
-./src/system/systemRecovery.o 
+./src/system/systemRecovery.o \
+./src/system/systemStepControl.o 
 
 CPP_DEPS += \
 ./src/system/system.d \
+./src/system/systemAutotune.d \
 ./src/system/systemHandling.d \
 ./src/system/systemInit.d \
-./src/system/systemRecovery.d 
+./src/system/systemRecovery.d \
+./src/system/systemStepControl.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
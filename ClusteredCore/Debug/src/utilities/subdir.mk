@@ -4,26 +4,47 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/utilities/arena.cpp \
 ../src/utilities/config.cpp \
 ../src/utilities/diagnostics.cpp \
 ../src/utilities/error.cpp \
 ../src/utilities/fastRandom.cpp \
+../src/utilities/fft.cpp \
+../src/utilities/memoryBudget.cpp \
+../src/utilities/memoryTracker.cpp \
+../src/utilities/noiseQueue.cpp \
+../src/utilities/numa.cpp \
+../src/utilities/philox.cpp \
 ../src/utilities/timer.cpp \
 ../src/utilities/utilities.cpp 
 
 OBJS += \
+./src/utilities/arena.o \
 ./src/utilities/config.o \
 ./src/utilities/diagnostics.o \
 ./src/utilities/error.o \
 ./src/utilities/fastRandom.o \
+./src/utilities/fft.o \
+./src/utilities/memoryBudget.o \
+./src/utilities/memoryTracker.o \
+./src/utilities/noiseQueue.o \
+./src/utilities/numa.o \
+./src/utilities/philox.o \
 ./src/utilities/timer.o \
 ./src/utilities/utilities.o 
 
 CPP_DEPS += \
+./src/utilities/arena.d \
 ./src/utilities/config.d \
 ./src/utilities/diagnostics.d \
 ./src/utilities/error.d \
 ./src/utilities/fastRandom.d \
+./src/utilities/fft.d \
+./src/utilities/memoryBudget.d \
+./src/utilities/memoryTracker.d \
+./src/utilities/noiseQueue.d \
+./src/utilities/numa.d \
+./src/utilities/philox.d \
 ./src/utilities/timer.d \
 ./src/utilities/utilities.d 
 
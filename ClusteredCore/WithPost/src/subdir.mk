@@ -5,15 +5,18 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../src/defs.cpp \
-../src/particle.cpp 
+../src/particle.cpp \
+../src/particleStore.cpp 
 
 OBJS += \
 ./src/defs.o \
-./src/particle.o 
+./src/particle.o \
+./src/particleStore.o 
 
 CPP_DEPS += \
 ./src/defs.d \
-./src/particle.d 
+./src/particle.d \
+./src/particleStore.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -1,7 +1,10 @@
 #ifndef DEFAULTANALYSIS_H_
 #define DEFAULTANALYSIS_H_
 
+#include <thread>
+#include <atomic>
 #include "particle.h"
+#include "arena.h"
 #include "interfaces/IAnalysisManager.h"
 
 using namespace std;
@@ -11,6 +14,20 @@ namespace PSim {
 class analysisManager : public PSim::IAnalysisManager {
 
 private:
+	// The system at one snapshot. Either views of the live particles, or a copy for the writer thread.
+	struct frame {
+		// Holds the copied data. NULL for a live view.
+		particleStore* store;
+		// Copies by name. Copy n sits in slot n of the store.
+		particle** byName;
+		// Particles in the order of the system.
+		particle** items;
+		// Boundary crossings of each particle at the snapshot.
+		const int* pbc[3];
+		double currentTime;
+		// Console lines, printed by the main thread once the frame is written.
+		std::vector<std::string> messages;
+	};
 	// Number of times a particles has crossed a periodic boundary.
 	int* xPBC;
 	int* yPBC;
@@ -19,9 +36,27 @@ private:
 	float* xStart;
 	float* yStart;
 	float* zStart;
+	// Holds the tracker arrays.
+	arena trackerPool{"analysis"};
+	// Work space of one analysis pass. Reset rather than freed.
+	arena scratch{"analysis"};
+	// Snapshots are copied into one frame while the writer works on the other.
+	bool async;
+	frame frames[2];
+	int nextFrame;
+	int frameSize;
+	// Holds the particles and crossing counts of both frames.
+	arena framePool{"analysis"};
+	std::thread writer;
+	std::atomic<bool> written;
+	// Console lines of the frame being written. NULL to print straight away.
+	std::vector<std::string>* pending;
 	// System parameters
 	int counter;
+	// Time of the next snapshot when the time step is adaptive.
+	double nextOutput;
 	int boxSize;
+	int nSpecies;
 	string trialName = "";
 
 	/**
@@ -50,9 +85,10 @@ private:
 	 * Calculate the average total square displacement.
 	 * @param particles
 	 * @param nParticles
+	 * @param pbc Boundary crossings in x, y and z.
 	 * @return
 	 */
-	double trackedDisplacement(particle** particles, int nParticles);
+	double trackedDisplacement(particle** particles, int nParticles, const int* const* pbc);
 	/**
 	 * Histogram of particle coordination number.
 	 * @param particles
@@ -79,21 +115,46 @@ private:
 	 * @param name
 	 */
 	void writeSystem(particle** particles, int nParticles, std::string name);
-	void clusterCoorHistogram(std::vector<std::vector<particle*>> clusterPool);
-	void clusterSizeHistogram(std::vector<std::vector<particle*>> clusterPool);
-	void writeSystemState(particle** particles, int nParticles, double currentTime);
+	void clusterCoorHistogram(const std::vector<std::vector<particle*>>& clusterPool);
+	void clusterSizeHistogram(const std::vector<std::vector<particle*>>& clusterPool);
+	void writeSystemState(frame* f, int nParticles);
+	/**
+	 * Copy positions, forces and contacts into a frame.
+	 * @param f
+	 * @param particles
+	 * @param nParticles
+	 * @param currentTime
+	 */
+	void capture(frame* f, particle** particles, int nParticles, double currentTime);
+	/**
+	 * Join the writer thread if it has finished, and print its console lines.
+	 * @param block Wait for the writer if it is still running.
+	 */
+	void collect(bool block);
+	/**
+	 * Print a console line, or hold it for the main thread when called by the writer.
+	 * @param message
+	 */
+	void say(const std::string& message);
 	std::vector<std::vector<particle*>> findClusters(particle** particles, int nParticles);
-	int writeClusters(std::vector<std::vector<particle*>> clusterPool, double currentTime, int xyz);
+	int writeClusters(const std::vector<std::vector<particle*>>& clusterPool, double currentTime, int xyz);
 	void writeSystemXYZ(particle** particles, int nParticles, int outXYZ, double currentTime,string name);
 	void clusterSizeHistogram(particle** particles, int nParticles) { clusterSizeHistogram(findClusters(particles, nParticles)); }
 	int writeClusters(particle** particles, int nParticles, double currentTime, int xyz) { return writeClusters(findClusters(particles, nParticles),currentTime,xyz); }
 
 public:
-	analysisManager(string tName, systemState* state);
+	/**
+	 * @param tName The trial directory.
+	 * @param state The system state.
+	 * @param asyncOutput Write snapshots on a background thread while the system runs.
+	 */
+	analysisManager(string tName, systemState* state, bool asyncOutput = false);
+	~analysisManager();
 	void postAnalysis(std::queue<std::string>* tests, particle** particles, systemState* state);
 	void writeInitialState(particle** particles, systemState* state);
 	void writeFinalState(particle** particles, systemState* state);
 	void writeRunTimeState(particle** particles, systemState* state);
+	void flush();
 };
 }
 
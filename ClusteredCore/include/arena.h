@@ -0,0 +1,100 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <cstddef>
+#include <vector>
+#include <new>
+#include <utility>
+#include "memoryTracker.h"
+
+namespace PSim {
+
+/**
+ * @class arena
+ * @file arena.h
+ * @brief Bump allocator for memory that is freed all at once.
+ *
+ * Memory comes from a list of large chunks, each cut on 64 byte boundaries.
+ * Nothing is freed on its own. Reset rewinds the arena and keeps the chunks,
+ * so scratch that is rebuilt every step settles to a fixed footprint with no
+ * calls to the system allocator. An arena belongs to one owner and is not
+ * shared between threads.
+ */
+class arena {
+
+private:
+
+	//Blocks from numa::reserve.
+	std::vector<std::pair<char*, size_t>> chunks;
+	//Chunk being cut, and the bytes used in it.
+	size_t current;
+	size_t offset;
+	//Smallest chunk to request.
+	size_t chunkSize;
+	//Owner the chunks are counted against in the memoryTracker.
+	const char* component;
+	//Tracker of the thread that made the arena. Chunks may be added from any thread of its team.
+	memoryTracker* tracker;
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	/**
+	 * @brief Creates an empty arena. No memory is reserved until the first take.
+	 * @param owner The component the chunks are counted against.
+	 * @param chunkBytes The smallest chunk to reserve.
+	 */
+	arena(const char* owner = "scratch", size_t chunkBytes = 1 << 20);
+	~arena();
+
+	//Pointers into the chunks would dangle.
+	arena(const arena&) = delete;
+	arena& operator=(const arena&) = delete;
+
+	/**
+	 * @brief Takes a 64 byte aligned block.
+	 * @param bytes The size of the block.
+	 * @return The block. Valid until the next reset or release.
+	 */
+	void* take(size_t bytes);
+	/**
+	 * @brief Takes an uninitialized array.
+	 * @param n The number of elements.
+	 */
+	template<typename T> T* allocate(size_t n) {
+		return (T*) take(n * sizeof(T));
+	}
+	/**
+	 * @brief Constructs an object in the arena. The owner calls its destructor.
+	 */
+	template<typename T, typename... Args> T* create(Args&&... args) {
+		return new (take(sizeof(T))) T(std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @brief Rewinds the arena. Chunks are kept for reuse and no destructors run.
+	 */
+	void reset() {
+		current = 0;
+		offset = 0;
+	}
+	/**
+	 * @brief Frees every chunk.
+	 */
+	void release();
+
+	/**
+	 * @brief Bytes handed out since the last reset.
+	 */
+	size_t used() const;
+	/**
+	 * @brief Bytes held in chunks.
+	 */
+	size_t reserved() const;
+
+};
+
+}
+
+#endif // ARENA_H
@@ -0,0 +1,132 @@
+#ifndef BAOAB_INTEGRATOR_H
+#define BAOAB_INTEGRATOR_H
+#include "forceManager.h"
+#include "interfaces/IIntegrator.h"
+#include "noiseQueue.h"
+#include <omp.h>
+
+namespace PSim {
+/********************************************//**
+ *------------BAOAB LANGEVIN INTEGRATOR-----------
+ ************************************************/
+
+/**
+ * @class baoabIntegrator
+ * @file baoabIntegrator.h
+ * @brief Langevin dynamics by the BAOAB splitting.
+ *
+ * Each step is a half kick (B), a half drift (A), an exact Ornstein-Uhlenbeck
+ * update of the velocity (O), a half drift (A) and a half kick (B). The
+ * configurational distribution is correct to second order in dt, so much
+ * larger steps sample the same structure. See LEIMKUHLER AND MATTHEWS 2013.
+ *
+ * Forces are only known at the start of a step, so the closing half kick of
+ * one step is merged into the opening half kick of the next. The velocity
+ * stored on a particle is therefore missing its last half kick.
+ */
+class baoabIntegrator: public IIntegrator {
+
+private:
+
+	//System variables
+	double kT;
+	int memSize;
+
+	//Variables vital to the integrator.
+	double gamma;
+	double dt;
+	//Time step of the last step. Zero before the first step.
+	double dtLast;
+	double dtSave;
+	//Noise step saved for a rejected step.
+	uint64_t stepSave;
+
+	//Ornstein-Uhlenbeck coefficients exp(-gamma dt) and sqrt(1 - c1^2).
+	double c1;
+	double c2;
+
+	//Gaussian deviates. Three per particle, filled a step ahead.
+	noiseQueue* queue;
+
+	//Integration step. Counter for the noise.
+	uint64_t step;
+
+	//Random number seed;
+	int seed;
+
+public:
+
+	/**
+	 * @brief Constructs the BAOAB integrator.
+	 * @param cfg The address of the configuration file reader.
+	 * @return Nothing
+	 */
+	baoabIntegrator(config* cfg);
+	/**
+	 * @brief Deconstructs the integrator.
+	 * @return Nothing.
+	 */
+	~baoabIntegrator();
+
+	/**
+	 * @brief Bytes the integrator allocates for the configured system.
+	 * @param cfg The address of the configuration file reader.
+	 */
+	static double memoryEstimate(config* cfg);
+
+	/**
+	 * @brief Integrates to the next system state.
+	 * @param items The particles in the the system.
+	 * @param state The system state.
+	 * @return Return 0 for no error.
+	 */
+	int nextSystem(PSim::particle** items, systemState* state);
+	/**
+	 * @brief Changes the time step and the Ornstein-Uhlenbeck coefficients.
+	 * @param newDt The new time step.
+	 * @return True.
+	 */
+	bool setTimeStep(double newDt);
+	/**
+	 * @brief The kicks of one step carry a particle dt^2 F / m.
+	 * @param force The magnitude of the force.
+	 * @param mass The mass of the particle.
+	 */
+	double getDrift(double force, double mass) {
+		return dt * dt * force / mass;
+	}
+	/**
+	 * @brief The velocities are kicked on every step.
+	 */
+	bool stepsVelocity() {
+		return true;
+	}
+	/**
+	 * @brief Saves the pending half kick and the noise step before a trial step.
+	 */
+	void saveState() {
+		dtSave = dtLast;
+		stepSave = step;
+	}
+	/**
+	 * @brief Restores the pending half kick after a rejected step.
+	 * The retry draws the same deviates at its own time step.
+	 */
+	void restoreState() {
+		dtLast = dtSave;
+		step = stepSave;
+		queue->rewind(step);
+	}
+	/**
+	 * @brief Drops the prefetched noise, which was drawn in the old order.
+	 * Waits for the producer, which reads the particle ids.
+	 */
+	void beginReorder() {
+		queue->invalidate();
+	}
+
+};
+
+}
+
+#endif // BAOAB_INTEGRATOR_H
@@ -0,0 +1,130 @@
+#ifndef CELL_SCHEDULER_H
+#define CELL_SCHEDULER_H
+#include <omp.h>
+#include <atomic>
+#include <vector>
+#include <tuple>
+#include <cstdint>
+#include "structs/systemState.h"
+
+namespace PSim {
+
+/**
+ * @class cellScheduler
+ * @file cellScheduler.h
+ * @brief Splits the force pass into cell blocks of equal pair work, with work stealing.
+ *
+ * Each cell is weighted by its mobile occupancy times the occupancy of its
+ * 27 neighbor cells, which is the number of pairs its particles test. Runs
+ * of whole cells are cut into blocks of near equal weight and dealt to the
+ * threads in order, so a thread starts on a contiguous part of the box. A
+ * thread that empties its queue takes blocks from the back of the others.
+ * Forces are gathered per particle, so the result does not depend on which
+ * thread takes a block.
+ */
+class cellScheduler {
+
+public:
+
+	//A run of cells and the mobile particles they hold in sorted order.
+	struct block {
+		int firstCell;
+		int endCell;
+		int firstParticle;
+		int endParticle;
+	};
+
+private:
+
+	//Blocks for every thread, in cell order.
+	std::vector<block> blocks;
+	//Front and back of each thread's queue, packed so both ends move with one compare and swap.
+	std::vector<std::atomic<uint64_t>> queues;
+	//Blocks cut per thread. More blocks balance better but steal more often.
+	int blocksPerThread;
+
+	//Pair work and mobile particles of each cell.
+	std::vector<double> weight;
+	std::vector<int> occupancy;
+	std::vector<int> firstParticle;
+
+	//Seconds each thread spent on blocks, and the wall time of the passes, since the last report.
+	std::vector<double> busy;
+	double wall;
+	int passes;
+
+	static uint64_t pack(uint32_t front, uint32_t back) {
+		return ((uint64_t) back << 32) | front;
+	}
+	/**
+	 * @brief Takes the next block from the front of a thread's own queue.
+	 * @return The block index, or -1 if the queue is empty.
+	 */
+	int popFront(int t);
+	/**
+	 * @brief Takes a block from the back of another thread's queue.
+	 * @return The block index, or -1 if the queue is empty.
+	 */
+	int popBack(int t);
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	cellScheduler();
+
+	/**
+	 * @brief Set how many blocks each thread is dealt.
+	 * @param n Blocks per thread.
+	 */
+	void setBlocksPerThread(int n) {
+		blocksPerThread = (n > 0) ? n : 1;
+	}
+
+	/**
+	 * @brief Weighs the cells and cuts the blocks for this step.
+	 * @param cellStartEnd The cell run table.
+	 * @param state The system state.
+	 * @param threads The size of the team that will run the blocks.
+	 */
+	void plan(std::vector<std::tuple<int,int>>* cellStartEnd, systemState* state, int threads);
+
+	/**
+	 * @brief Runs every block across the team. Call from inside a parallel region.
+	 * @param work Called with each block by the thread that takes it.
+	 */
+	template<typename F> void run(F work) {
+		int t = omp_get_thread_num();
+		double start = omp_get_wtime();
+		for (int b = popFront(t); b >= 0; b = popFront(t)) {
+			work(blocks[b]);
+		}
+		for (int b = popBack(t); b >= 0; b = popBack(t)) {
+			work(blocks[b]);
+		}
+		busy[t] += omp_get_wtime() - start;
+	}
+
+	/**
+	 * @brief Adds the wall time of one pass, for the busy fractions.
+	 */
+	void addWall(double seconds) {
+		wall += seconds;
+		passes++;
+	}
+
+	/**
+	 * @brief Prints the fraction of the force passes each thread was busy, then restarts the count.
+	 */
+	void report();
+	/**
+	 * @brief Drops the busy and wall times counted so far.
+	 */
+	void clear();
+
+};
+
+}
+
+#endif // CELL_SCHEDULER_H
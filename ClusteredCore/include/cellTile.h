@@ -0,0 +1,90 @@
+#ifndef CELL_TILE_H
+#define CELL_TILE_H
+#include <vector>
+#include <tuple>
+#include "structs/systemState.h"
+#include "memoryTracker.h"
+
+namespace PSim {
+
+/**
+ * @class cellTile
+ * @file cellTile.h
+ * @brief Staged copy of a home cell and its 26 neighbors.
+ *
+ * The coordinates of every run around a home cell are copied once into
+ * aligned SoA buffers. Every particle in the home cell is then evaluated
+ * against the tile, so neighbor coordinates are read from sortedParticles
+ * once per cell rather than once per particle. Runs are staged in the same
+ * order as the per particle traversal, so the force sums are unchanged.
+ */
+class cellTile {
+
+public:
+
+	/**
+	 * @struct tileRun
+	 * @brief A run of one species in one cell of the tile.
+	 */
+	struct tileRun {
+		//Range of the run in the tile buffers.
+		int begin;
+		int end;
+		//Species of the run.
+		int species;
+		//Hash of the cell holding the run.
+		int hash;
+		//Neighbor slot of the cell, 0 to 26.
+		int cell;
+	};
+
+private:
+
+	//Number of particles the buffers can hold.
+	int capacity;
+	//Tracker of the thread that made the tile. The tile grows on a team thread.
+	memoryTracker* tracker;
+
+	/**
+	 * @brief Grows the buffers.
+	 * @param n The number of particles needed.
+	 */
+	void reserve(int n);
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	//Tile coordinates, radius and sorted index.
+	double* x;
+	double* y;
+	double* z;
+	double* r;
+	int* index;
+	//Number of staged particles.
+	int size;
+
+	//Staged runs in traversal order.
+	std::vector<tileRun> runs;
+	//Mobile runs of the home cell. Ranges are sorted indices.
+	std::vector<tileRun> home;
+
+	cellTile();
+	~cellTile();
+
+	/**
+	 * @brief Stages a home cell and its neighbors.
+	 * @param hash The hash of the home cell.
+	 * @param sortedParticles The cell sorted particle positions.
+	 * @param cellStartEnd The sorted range of each run.
+	 * @param state The system state.
+	 * @return False if the home cell has no mobile particles. Nothing is staged.
+	 */
+	bool load(int hash, double* sortedParticles, std::vector<std::tuple<int,int>>* cellStartEnd, systemState* state);
+
+};
+
+}
+
+#endif // CELL_TILE_H
@@ -37,6 +37,18 @@ public:
 	 */
 	template<typename T> T getParam(string key, T def);
 
+	/**
+	 * @brief Set an option, replacing the value from the configuration file.
+	 * @param key The keyword of the option.
+	 * @param val The new value.
+	 */
+	template<typename T> void setParam(string key, T val) {
+		std::ostringstream out;
+		out.precision(17);
+		out << val;
+		options[key] = out.str();
+	}
+
 	/**
 	 * @brief Check that the key is in the configuration file.
 	 * @param key The keyword to search.
@@ -46,6 +58,13 @@ public:
 		return options.count(key);
 	}
 
+	/**
+	 * @brief Applies the settings of one replica of an ensemble.
+	 * Each 'key@k' replaces 'key' for replica k.
+	 * @param k The replica.
+	 */
+	void selectReplica(int k);
+
 	/**
 	 * @brief Show configuration output.
 	 */
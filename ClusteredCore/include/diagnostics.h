@@ -21,6 +21,8 @@ class Diagnostics {
 protected:
 	int chatter;
 	void addToChatter() { chatter+=1; }
+	//Messages from this thread go here instead of the console. NULL for the console.
+	static thread_local ostream* sink;
 public:
 	//Header Version.
 	static const int version = 1;
@@ -33,6 +35,15 @@ public:
 	void resetChatterCount() { chatter = 0; };
 	void startErrorLog(int _code, string _name);
 	void consoleMessage(string _message, int level = 0);
+	/**
+	 * @brief Sends the messages of the calling thread to a stream, such as the log of one replica.
+	 * @param out The stream. NULL returns the thread to the console.
+	 */
+	void redirect(ostream* out) { sink = out; }
+	/**
+	 * @brief True if the calling thread writes to a stream other than the console.
+	 */
+	bool redirected() const { return sink != NULL; }
 };
 
 }
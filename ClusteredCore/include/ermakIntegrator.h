@@ -0,0 +1,113 @@
+#ifndef ERMAK_INTEGRATOR_H
+#define ERMAK_INTEGRATOR_H
+#include "forceManager.h"
+#include "interfaces/IIntegrator.h"
+#include "noiseQueue.h"
+#include <omp.h>
+
+namespace PSim {
+/********************************************//**
+ *-----------OVERDAMPED BROWNIAN INTEGRATOR-------
+ ************************************************/
+
+/**
+ * @class ermakIntegrator
+ * @file ermakIntegrator.h
+ * @brief Overdamped brownian dynamics without hydrodynamics.
+ *
+ * Ermak-McCammon step dx = F dt / (m gamma) + sqrt(2 kT dt / (m gamma)) z.
+ * Valid when gamma dt >> 1. Nothing is carried between steps, so there is no
+ * correlated kick memory and no velocity reconstruction.
+ * See ERMAK AND MCCAMMON 1978.
+ */
+class ermakIntegrator: public IIntegrator {
+
+private:
+
+	//System variables
+	double kT;
+	int memSize;
+
+	//Variables vital to the integrator.
+	double gamma;
+	double dt;
+
+	//Gaussian deviates. Three per particle, filled a step ahead.
+	noiseQueue* queue;
+
+	//Integration step. Counter for the noise.
+	uint64_t step;
+	//Noise step saved for a rejected step.
+	uint64_t stepSave;
+
+	//Random number seed;
+	int seed;
+
+public:
+
+	/**
+	 * @brief Constructs the overdamped integrator.
+	 * @param cfg The address of the configuration file reader.
+	 * @return Nothing
+	 */
+	ermakIntegrator(config* cfg);
+	/**
+	 * @brief Deconstructs the integrator.
+	 * @return Nothing.
+	 */
+	~ermakIntegrator();
+
+	/**
+	 * @brief Bytes the integrator allocates for the configured system.
+	 * @param cfg The address of the configuration file reader.
+	 */
+	static double memoryEstimate(config* cfg);
+
+	/**
+	 * @brief Integrates to the next system state.
+	 * @param items The particles in the the system.
+	 * @param state The system state.
+	 * @return Return 0 for no error.
+	 */
+	int nextSystem(PSim::particle** items, systemState* state);
+	/**
+	 * @brief Changes the time step.
+	 * @param newDt The new time step.
+	 * @return True.
+	 */
+	bool setTimeStep(double newDt);
+	/**
+	 * @brief The overdamped drift dt F / (m gamma).
+	 * @param force The magnitude of the force.
+	 * @param mass The mass of the particle.
+	 */
+	double getDrift(double force, double mass) {
+		return dt * force / (mass * gamma);
+	}
+	/**
+	 * @brief Saves the noise step before a trial step.
+	 */
+	void saveState() {
+		stepSave = step;
+	}
+	/**
+	 * @brief Returns to the saved noise step after a rejected step.
+	 * The retry draws the same deviates at its own time step.
+	 */
+	void restoreState() {
+		step = stepSave;
+		queue->rewind(step);
+	}
+	/**
+	 * @brief Drops the prefetched noise, which was drawn in the old order.
+	 * Waits for the producer, which reads the particle ids.
+	 */
+	void beginReorder() {
+		queue->invalidate();
+	}
+
+};
+
+}
+
+#endif // ERMAK_INTEGRATOR_H
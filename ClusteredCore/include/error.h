@@ -1,7 +1,9 @@
 #ifndef ERROR_H
 #define ERROR_H
 #include "defs.h"
+#include <atomic>
 #include <exception>
+#include <string>
 #include "structs/type3.h"
 
 namespace PSim {
@@ -12,14 +14,46 @@ namespace PSim {
  * @date 06/27/15
  * @file error.h
  * @brief Contains information for common runtime errors.
+ *
+ * Each throw function writes the error log and then throws the error. A run
+ * started from main exits with the error code. An ensemble catches it and
+ * ends only the replica that raised it.
  */
 class error: public std::exception {
 
+private:
+
+	int errorCode;
+	std::string text;
+
+	/**
+	 * @brief Starts the error log.
+	 * @return The error to throw once the log is complete.
+	 */
+	static error begin(int code, std::string name);
+
 public:
 
 	//Header Version.
 	static const int version = 1;
 
+	/**
+	 * @brief Creates an error.
+	 * @param code The exit code of the error.
+	 * @param name What went wrong.
+	 */
+	error(int code, std::string name);
+
+	/**
+	 * @brief The exit code of the error.
+	 */
+	int code() const {
+		return errorCode;
+	}
+	const char* what() const noexcept {
+		return text.c_str();
+	}
+
 	/**
 	 * @brief Throw when system initial conditions cannot be resolved.
 	 */
@@ -49,6 +83,63 @@ public:
 	 * @brief Throw when input arguments are invalid.
 	 */
 	static void throwInputError();
+	/**
+	 * @brief Throw when the adaptive time step cannot shrink any further.
+	 * @param dt The time step of the rejected step.
+	 * @param gap The closest pair distance over contact distance.
+	 */
+	static void throwTimeStepError(double dt, double gap);
+	/**
+	 * @brief Throw when the system does not fit the node or the 32 bit indices.
+	 * @param what The quantity over its limit.
+	 * @param need The size the run asks for.
+	 * @param limit The largest size allowed.
+	 */
+	static void throwSystemSizeError(std::string what, double need, double limit);
+	/**
+	 * @brief Throw when the seed cube holds more particles than the system.
+	 * @param seedSize The edge of the seed cube.
+	 * @param nParticles The number of particles in the system.
+	 */
+	static void throwSeedSizeError(int seedSize, int nParticles);
+
+};
+
+/**
+ * @class teamError
+ * @file error.h
+ * @brief The first error raised by the threads of an OpenMP team.
+ *
+ * An exception may not leave a parallel region, and a thread that left early
+ * would hold the rest of the team at the next barrier. Team loops catch their
+ * errors here and skip the rest of their work. The error is thrown again once
+ * the region has closed.
+ */
+class teamError {
+
+private:
+
+	std::exception_ptr first;
+	std::atomic<bool> failed;
+
+public:
+
+	teamError() : failed(false) {}
+
+	/**
+	 * @brief Keeps the error being handled. Call from a catch block.
+	 */
+	void record();
+	/**
+	 * @brief Checks if a thread of the team has failed.
+	 */
+	bool raised() const {
+		return failed.load(std::memory_order_relaxed);
+	}
+	/**
+	 * @brief Throws the kept error and clears it. Call outside the region.
+	 */
+	void rethrow();
 
 };
 
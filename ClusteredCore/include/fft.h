@@ -0,0 +1,79 @@
+#ifndef FFT_H
+#define FFT_H
+#include <omp.h>
+#include <cmath>
+#include <vector>
+#include <complex>
+
+namespace PSim {
+
+/**
+ * @class fft3d
+ * @file fft.h
+ * @brief Local radix-2 fast fourier transform on a cubic grid.
+ */
+class fft3d {
+
+private:
+
+	//Points along each dimension. Must be a power of two.
+	int size;
+	//Twiddle factors for a single dimension.
+	std::vector<std::complex<double>> twiddle;
+	//Bit reversal table for a single dimension.
+	std::vector<int> reversal;
+
+	/**
+	 * @brief In place transform of a contiguous line.
+	 * @param line The line to transform.
+	 * @param inverse True for the backward transform.
+	 */
+	void transformLine(std::complex<double>* line, bool inverse);
+	/**
+	 * @brief Transforms every line of the grid along one axis.
+	 * @param grid The grid to transform.
+	 * @param stride The distance between neighboring points on the axis.
+	 * @param inverse True for the backward transform.
+	 */
+	void transformAxis(std::complex<double>* grid, int stride, bool inverse);
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	/**
+	 * @brief Creates the transform tables.
+	 * @param n The number of grid points in each dimension.
+	 */
+	fft3d(int n);
+	~fft3d();
+
+	/**
+	 * @brief Unnormalized forward transform. exp(-2 pi i k m / n)
+	 * @param grid The n^3 grid in x fastest order.
+	 */
+	void forward(std::complex<double>* grid);
+	/**
+	 * @brief Unnormalized backward transform. exp(+2 pi i k m / n)
+	 * @param grid The n^3 grid in x fastest order.
+	 */
+	void backward(std::complex<double>* grid);
+
+	/**
+	 * @brief Gets the number of points along each dimension.
+	 */
+	int getSize() const {
+		return size;
+	}
+
+	/**
+	 * @brief The smallest power of two greater than or equal to n.
+	 */
+	static int nextPowerOfTwo(int n);
+
+};
+
+}
+
+#endif // FFT_H
@@ -3,7 +3,10 @@
 #include <omp.h>
 #include "config.h"
 #include "particle.h"
+#include "cellTile.h"
+#include "cellScheduler.h"
 #include "interfaces/IForce.h"
+#include "error.h"
 
 namespace PSim {
 
@@ -26,9 +29,16 @@ private:
 	std::vector<IForce*> flist;
 	//Flagged if flist contains a time dependant force.
 	bool timeDependent;
+	//Staging tile for each thread.
+	std::vector<cellTile*> tiles;
+	//Deals the cells to the threads by their pair work.
+	cellScheduler scheduler;
 
 public:
 
+	//First error raised by a force while the team was running.
+	teamError failure;
+
 	/**
 	 * @brief Creates the force management system.
 	 */
@@ -53,6 +63,16 @@ public:
 	 * @param items The particles in the system.
 	 */
 	void getAcceleration(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+	/**
+	 * @brief The serial part of getAcceleration. Call before the team that runs getAccelerationInTeam.
+	 * Global force terms run here, since they open their own parallel regions.
+	 */
+	void prepareAcceleration(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+	/**
+	 * @brief The pair loop of getAcceleration. Called by every thread of an open parallel region.
+	 * Ends with a barrier, so the forces are complete on return.
+	 */
+	void getAccelerationInTeam(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
 
 	/**
 	 * @brief Checks if the system contains a time dependent force.
@@ -78,6 +98,25 @@ public:
 	void setDynamic(int num) {
 		omp_set_dynamic(num);
 	}
+	/**
+	 * @brief Set how many cell blocks each thread is dealt per force pass.
+	 * @param num Blocks per thread.
+	 */
+	void setBlocksPerThread(int num) {
+		scheduler.setBlocksPerThread(num);
+	}
+	/**
+	 * @brief Prints how busy each thread was in the force passes since the last report.
+	 */
+	void reportBalance() {
+		scheduler.report();
+	}
+	/**
+	 * @brief Forgets the force passes timed so far, so trial passes do not count.
+	 */
+	void clearBalance() {
+		scheduler.clear();
+	}
 	/**
 	 * @brief Set the default OMP target device.
 	 * @param num Device number.
@@ -113,6 +152,7 @@ public:
 	 * @param state
 	 */
 	void getPostRoutine(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+	void getPostRoutineInTeam(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
 #endif
 };
 
@@ -0,0 +1,195 @@
+#ifndef HYDRO_INTEGRATOR_H
+#define HYDRO_INTEGRATOR_H
+#include "forceManager.h"
+#include "interfaces/IIntegrator.h"
+#include "noiseQueue.h"
+#include "arena.h"
+#include <omp.h>
+
+namespace PSim {
+/********************************************//**
+ *---------HYDRODYNAMIC BROWNIAN INTEGRATOR-------
+ ************************************************/
+
+/**
+ * @class hydroIntegrator
+ * @file hydroIntegrator.h
+ * @brief Overdamped brownian dynamics with Rotne-Prager-Yamakawa hydrodynamics.
+ *
+ * Ermak-McCammon step dx = M F dt + sqrt(2 kT dt) M^(1/2) z. The RPY mobility is
+ * never stored. It is applied matrix free over a cell list with a minimum image
+ * cutoff. A Wendland taper keeps the truncated tensor positive definite, and
+ * M^(1/2) z is found by the lanczos method of CHOW AND SAAD 2014.
+ * Frozen particles are left out of the mobility, rows and columns, so they
+ * neither move nor couple to the mobile particles through the solvent.
+ * Velocities are not integrated.
+ */
+class hydroIntegrator: public IIntegrator {
+
+private:
+
+	//System variables
+	double mass;
+	double kT;
+	int memSize;
+
+	//Variables vital to the integrator.
+	double gamma;
+	double dt;
+	//Self mobility 1/(m gamma).
+	double mobility;
+	//Width of the brownian displacement sqrt(2 kT dt).
+	double noiseWidth;
+
+	//Hydrodynamic cutoff.
+	double cutOff;
+	double cutOffSquared;
+
+	//Lanczos settings.
+	int maxKrylov;
+	double tolerance;
+	//Set once the noise has failed to converge.
+	bool warnedKrylov;
+
+	//Particle data gathered for the step.
+	double* pos;
+	double* radius;
+	double* force;
+	double* drift;
+	double* brownian;
+	//Lanczos work space.
+	double* basis;
+	double* work;
+	//Small lanczos arrays, rebuilt every step.
+	arena scratch{"integrator"};
+
+	//Cell list for the mobility product.
+	int cellScale;
+	double cellWidth;
+	std::vector<int> cellHead;
+	std::vector<int> cellNext;
+	//Set for frozen particles, which are not in the cell list.
+	std::vector<char> frozen;
+
+	//Gaussian deviates. Three per particle, filled a step ahead.
+	noiseQueue* queue;
+	//Integration step. Counter for the noise.
+	uint64_t step;
+	//Noise step saved for a rejected step.
+	uint64_t stepSave;
+
+	//Random number seed;
+	int seed;
+
+	/**
+	 * @brief Gathers the particle positions and bins them into cells.
+	 * @param items The particles in the system.
+	 * @param state The system state.
+	 */
+	void buildCells(PSim::particle** items, systemState* state);
+	/**
+	 * @brief Applies the RPY mobility to a vector.
+	 * @param in The 3N vector to multiply.
+	 * @param out The 3N result M * in.
+	 * @param state The system state.
+	 */
+	void applyMobility(const double* in, double* out, systemState* state);
+	/**
+	 * @brief Adds the RPY coupling of particle j onto particle i.
+	 * @param i,j The particle pair.
+	 * @param in The 3N vector being multiplied.
+	 * @param sum The running product for particle i.
+	 * @param boxSize The size of the system.
+	 */
+	void addPair(int i, int j, const double* in, double* sum, double boxSize);
+	/**
+	 * @brief Lanczos approximation of M^(1/2) z.
+	 * @param z The 3N gaussian vector.
+	 * @param out The 3N correlated displacement.
+	 * @param state The system state.
+	 */
+	void sqrtMobility(const double* z, double* out, systemState* state);
+	/**
+	 * @brief Computes T^(1/2) e1 for a symmetric tridiagonal matrix.
+	 * @param diag The diagonal of T.
+	 * @param offDiag The off diagonal of T.
+	 * @param n The size of T.
+	 * @param result The first column of T^(1/2).
+	 * @param space Work space of 2 * n * n doubles.
+	 */
+	static void tridiagonalSqrt(const double* diag, const double* offDiag, int n, double* result, double* space);
+	/**
+	 * @brief Parallel dot product.
+	 * @param a,b The vectors.
+	 * @param n The length of the vectors.
+	 */
+	double dot(const double* a, const double* b, int n);
+
+public:
+
+	/**
+	 * @brief Constructs the hydrodynamic integrator.
+	 * @param cfg The address of the configuration file reader.
+	 * @return Nothing
+	 */
+	hydroIntegrator(config* cfg);
+	/**
+	 * @brief Deconstructs the integrator.
+	 * @return Nothing.
+	 */
+	~hydroIntegrator();
+
+	/**
+	 * @brief Bytes the integrator allocates for the configured system.
+	 * @param cfg The address of the configuration file reader.
+	 */
+	static double memoryEstimate(config* cfg);
+
+	/**
+	 * @brief Integrates to the next system state.
+	 * @param items The particles in the the system.
+	 * @param state The system state.
+	 * @return Return 0 for no error.
+	 */
+	int nextSystem(PSim::particle** items, systemState* state);
+	/**
+	 * @brief Changes the time step and the width of the brownian displacement.
+	 * @param newDt The new time step.
+	 * @return True.
+	 */
+	bool setTimeStep(double newDt);
+	/**
+	 * @brief The overdamped drift dt F / (m gamma).
+	 * @param force The magnitude of the force.
+	 * @param mass The mass of the particle.
+	 */
+	double getDrift(double force, double mass) {
+		return dt * force / (mass * gamma);
+	}
+	/**
+	 * @brief Saves the noise step before a trial step.
+	 */
+	void saveState() {
+		stepSave = step;
+	}
+	/**
+	 * @brief Returns to the saved noise step after a rejected step.
+	 * The retry draws the same deviates at its own time step.
+	 */
+	void restoreState() {
+		step = stepSave;
+		queue->rewind(step);
+	}
+	/**
+	 * @brief Drops the prefetched noise, which was drawn in the old order.
+	 * Waits for the producer, which reads the particle ids.
+	 */
+	void beginReorder() {
+		queue->invalidate();
+	}
+
+};
+
+}
+
+#endif // HYDRO_INTEGRATOR_H
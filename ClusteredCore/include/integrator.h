@@ -2,7 +2,7 @@
 #define INTEGRATOR_H
 #include "forceManager.h"
 #include "interfaces/IIntegrator.h"
-#include "fastRandom.h"
+#include "noiseQueue.h"
 #include <omp.h>
 
 namespace PSim {
@@ -49,8 +49,31 @@ private:
 	double * memCorrY;
 	double * memCorrZ;
 
-	//Random number storage for parallel compute
-	fastRandom** rndGens;
+	//Integration step. Counter for the noise.
+	uint64_t step;
+	//Gaussian deviates for the first step. Three per particle.
+	double* noise;
+	//Gaussian deviates for later steps. Six per particle, filled a step ahead.
+	noiseQueue* queue;
+
+	//Contiguous copies of the particle data for the SoA kernel.
+	double* soaBlock;
+	double* posX;
+	double* posY;
+	double* posZ;
+	double* oldX;
+	double* oldY;
+	double* oldZ;
+	double* frcX;
+	double* frcY;
+	double* frcZ;
+	double* oldFX;
+	double* oldFY;
+	double* oldFZ;
+	double* invMass;
+	double* newX;
+	double* newY;
+	double* newZ;
 
 	//Gaussian width.
 	double sig1;
@@ -68,15 +91,45 @@ private:
 	int velFreq;
 	int velCounter;
 
+	//Time step of the last step taken.
+	double dtLast;
+
+	//Kick memory, velocity counter and noise step saved for a rejected step.
+	double* memSave;
+	int velSave;
+	double dtSave;
+	uint64_t stepSave;
+
 	//Random number seed;
 	int seed;
 
+	//Particles past the box after a step. Shared by the team.
+	int outOfBounds;
+
 	/**
 	 * @brief Gets the width of the random gaussians according to G+B 2.12
 	 * @param gdt gamma * dT
 	 * @return
 	 */
 	double getWidth(double gdt);
+	/**
+	 * @brief Sets the time step and the G+B coefficients that depend on it.
+	 * @param cfg Config file reader.
+	 * @param newDt The time step.
+	 */
+	void setupCoefficients(config* cfg, double newDt);
+	/**
+	 * @brief Copies the particle data into the SoA arrays.
+	 * @param items The particles in the system.
+	 * @param state The system state. Its particle store is read directly when there is one.
+	 */
+	void gather(PSim::particle** items, systemState* state);
+	/**
+	 * @brief Wraps the new positions and writes them back to the particles and the cell bins.
+	 * @param items The particles in the system.
+	 * @param state The system state. Its particle store and cell bins are written when present.
+	 */
+	void scatter(PSim::particle** items, systemState* state);
 
 public:
 
@@ -92,6 +145,12 @@ public:
 	 */
 	~brownianIntegrator();
 
+	/**
+	 * @brief Bytes the integrator allocates for the configured system.
+	 * @param cfg The address of the configuration file reader.
+	 */
+	static double memoryEstimate(config* cfg);
+
 	/**
 	 * @brief Normal coefficents for high gamma.
 	 * @param cfg Config file reader.
@@ -120,6 +179,61 @@ public:
 	 * @return Return 0 for no error.
 	 */
 	int nextSystem(PSim::particle** items, systemState* state);
+	/**
+	 * @brief Integrates to the next system state. Called by every thread of an open parallel region.
+	 * @param items The particles in the the system.
+	 * @param state The system state.
+	 * @return Return 0 for no error.
+	 */
+	int nextSystemInTeam(PSim::particle** items, systemState* state);
+	bool runsInTeam() {
+		return true;
+	}
+	/**
+	 * @brief Changes the time step and recomputes the G+B coefficients.
+	 * @param newDt The new time step.
+	 * @return True.
+	 */
+	bool setTimeStep(double newDt);
+	/**
+	 * @brief The force term of G+B EQ 2.26, dt^2 coEff1 F / m.
+	 * @param force The magnitude of the force.
+	 * @param mass The mass of the particle.
+	 */
+	double getDrift(double force, double mass) {
+		return dt * dt * coEff1 * force / mass;
+	}
+	/**
+	 * @brief The velocities are only updated every step when velFreq is 0.
+	 */
+	bool stepsVelocity() {
+		return (velFreq == 0);
+	}
+	/**
+	 * @brief Saves the kick memory before a trial step.
+	 */
+	void saveState();
+	/**
+	 * @brief Restores the kick memory after a rejected step.
+	 */
+	void restoreState();
+	/**
+	 * @brief Drops the prefetched noise, which was drawn in the old order.
+	 * Waits for the producer, which reads the particle ids.
+	 */
+	void beginReorder() {
+		queue->invalidate();
+	}
+	/**
+	 * @brief Moves the kick memory to a new particle order.
+	 * @param order order[k] is the old index of the particle now at index k.
+	 * @param n The number of particles.
+	 */
+	void reorder(const int* order, int n) {
+#pragma omp parallel
+		reorderInTeam(order, n);
+	}
+	void reorderInTeam(const int* order, int n);
 
 	/**
 	 * @brief Integrates to the next system state.
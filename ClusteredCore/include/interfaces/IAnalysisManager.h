@@ -19,6 +19,8 @@ public:
 	virtual void writeFinalState(particle** particles, systemState* state) = 0;
 	/** Triggered base on outputFreq configuration option. */
 	virtual void writeRunTimeState(particle** particles, systemState* state) = 0;
+	/** Waits for any snapshot still being written. */
+	virtual void flush() {};
 
 };
 
@@ -19,7 +19,7 @@ protected:
 public:
 
 	//Header Version.
-	static const int version = 1;
+	static const int version = 3;
 
 	virtual ~IForce() {};
 
@@ -34,6 +34,36 @@ public:
 	 */
 	virtual void getAcceleration(int index, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state)=0;
 
+	/**
+	 * Called once per step before getAcceleration. Allows for global (non pairwise) calculations,
+	 * such as the reciprocal part of an ewald sum, to be done before the particle loop.
+	 * @param sortedParticles The cell sorted particle positions.
+	 * @param particleForce The force on each particle.
+	 * @param particleHashIndex The cell hash of each sorted particle.
+	 * @param cellStartEnd The sorted range of each cell.
+	 * @param state The system state.
+	 */
+	virtual void preRoutine(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state) {};
+
+	/**
+	 * @brief Flag for forces that evaluate a whole cell with getTileAcceleration.
+	 * @return True to use the tiled traversal in place of getAcceleration.
+	 */
+	virtual bool isTiled() { return false; };
+
+	/**
+	 * Finds the force on every mobile particle in a home cell.
+	 * The home cell and its neighbors are staged once into a thread local tile.
+	 * @param hash The home cell.
+	 * @param tile The staging buffer of the calling thread.
+	 * @param sortedParticles The cell sorted particle positions.
+	 * @param particleForce The force on each particle.
+	 * @param particleHashIndex The cell hash of each sorted particle.
+	 * @param cellStartEnd The sorted range of each cell.
+	 * @param state The system state.
+	 */
+	virtual void getTileAcceleration(int hash, cellTile* tile, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state) {};
+
 	/**
 	 * @brief Flag for a force dependent time.
 	 * @return True for time dependent. False otherwise.
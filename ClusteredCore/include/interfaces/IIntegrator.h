@@ -7,6 +7,7 @@
 
 #ifndef IINTEGRATOR_H_
 #define IINTEGRATOR_H_
+#include "error.h"
 
 namespace PSim
 {
@@ -26,7 +27,10 @@ protected:
 public:
 
 	//Header Version.
-	static const int version = 1;
+	static const int version = 6;
+
+	//First error raised by a thread while the integrator ran in a team.
+	teamError failure;
 
 	virtual ~IIntegrator() {};
 
@@ -42,6 +46,74 @@ public:
 	 * @return Return 0 for no error.
 	 */
 	virtual int nextSystem(PSim::particle** items, systemState* state)=0;
+	/**
+	 * @brief Integrates to the next system state from inside an open parallel region.
+	 * Every thread of the team calls it. Only used when runsInTeam is true.
+	 * @return Return 0 for no error.
+	 */
+	virtual int nextSystemInTeam(PSim::particle** items, systemState* state) {
+		return 1;
+	}
+	/**
+	 * @brief Checks if the integrator can step inside the system's team.
+	 * @return False if nextSystem must be called outside any parallel region.
+	 */
+	virtual bool runsInTeam() {
+		return false;
+	}
+
+	/**
+	 * @brief Changes the integration time step.
+	 * @param dt The new time step.
+	 * @return False if the integrator only runs at a fixed time step.
+	 */
+	virtual bool setTimeStep(double dt) {
+		return false;
+	}
+	/**
+	 * @brief The distance a force carries a particle in one step.
+	 * @param force The magnitude of the force.
+	 * @param mass The mass of the particle.
+	 * @return Zero if the integrator does not say.
+	 */
+	virtual double getDrift(double force, double mass) {
+		return 0;
+	}
+	/**
+	 * @brief Checks if the velocities are updated on every step.
+	 * @return False if the velocities cannot be used to judge a step.
+	 */
+	virtual bool stepsVelocity() {
+		return false;
+	}
+	/**
+	 * @brief Saves any state carried between steps, so a rejected step can be undone.
+	 */
+	virtual void saveState() {};
+	/**
+	 * @brief Returns to the state from the last saveState.
+	 */
+	virtual void restoreState() {};
+	/**
+	 * @brief Stops any background work that reads the particle order.
+	 * Called before the particle storage is permuted.
+	 */
+	virtual void beginReorder() {};
+	/**
+	 * @brief Moves any per particle state to a new particle order.
+	 * Integrators that keep state by particle index between steps must override this.
+	 * @param order order[k] is the old index of the particle now at index k.
+	 * @param n The number of particles.
+	 */
+	virtual void reorder(const int* order, int n) {};
+	/**
+	 * @brief The same as reorder, called by every thread of an open parallel region.
+	 * By default one thread calls reorder.
+	 */
+	virtual void reorderInTeam(const int* order, int n) {
+#pragma omp single
+		reorder(order, n);
+	}
 
 	/**
 	 * @brief Get the name of the integrator for logging purposes.
@@ -52,6 +124,9 @@ public:
 	}
 
 };
+
+typedef IIntegrator* create_Integrator(config*);
+
 }
 
 #endif /* IINTEGRATOR_H_ */
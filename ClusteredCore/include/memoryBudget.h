@@ -0,0 +1,78 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+#include <string>
+#include <vector>
+#include <utility>
+#include "config.h"
+
+namespace PSim {
+
+/**
+ * @class memoryBudget
+ * @file memoryBudget.h
+ * @brief Estimates the memory of a run from the configuration alone.
+ *
+ * Built before the integrator and the system, so a run that cannot fit is
+ * refused before anything large is allocated. Particle and cell indices are
+ * 32 bit, so the check also refuses systems past the limit of those indices.
+ *
+ * Settings (settings.cfg):
+ * memoryBudget - Limit in GB. 0 uses the physical memory of the node.
+ */
+class memoryBudget {
+
+private:
+
+	//Bytes by subsystem.
+	std::vector<std::pair<std::string, double>> entries;
+	//Set when part of the run could not be estimated.
+	std::string notCounted;
+
+	int nParticles;
+	//Entries in cellStartEnd.
+	double cellRuns;
+	//Limit in bytes.
+	double limit;
+	//Runs held in memory at once.
+	int copies;
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	//Largest system the 32 bit indices can address. sortedParticles is indexed by 4*i.
+	static const int maxParticles = 2147483647 / 4;
+
+	/**
+	 * @brief Builds the estimate.
+	 * @param cfg The address of the configuration file reader.
+	 */
+	memoryBudget(config* cfg);
+
+	/**
+	 * @brief Counts several runs of this size held at once, as in an ensemble.
+	 * @param n The number of runs.
+	 */
+	void setCopies(int n) {
+		copies = (n > 0) ? n : 1;
+	}
+
+	/**
+	 * @brief The estimated bytes of the whole run.
+	 */
+	double total() const;
+	/**
+	 * @brief Prints the estimate by subsystem.
+	 */
+	void report();
+	/**
+	 * @brief Exits with error 7708 if the run is over budget or past the index limits.
+	 */
+	void enforce();
+
+};
+
+}
+
+#endif // MEMORY_BUDGET_H
@@ -0,0 +1,144 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace PSim {
+
+/**
+ * @class memoryTracker
+ * @file memoryTracker.h
+ * @brief Current and peak bytes held by each part of the engine.
+ *
+ * Blocks are registered by address when allocated and removed when freed.
+ * numa::reserve does this for every block it hands out, so the particle
+ * store, the integrators and the arenas are counted without extra calls.
+ * Containers that grow on their own are counted with set, which replaces
+ * the bytes of a component each time it is measured.
+ *
+ * Each system in an ensemble keeps its own tracker. New blocks are counted
+ * against the tracker a thread has selected with use, or against the
+ * process tracker if it has none. A block is always removed from the
+ * tracker that counted it.
+ */
+class memoryTracker {
+
+private:
+
+	struct usage {
+		size_t current;
+		size_t peak;
+	};
+	struct block {
+		memoryTracker* owner;
+		std::string component;
+		size_t bytes;
+	};
+
+	//Usage by component.
+	std::map<std::string, usage> components;
+	//Bytes held by every component, now and at most.
+	size_t totalCurrent;
+	size_t totalPeak;
+
+	//Every registered block, whichever tracker counts it.
+	static std::map<const void*, block> blocks;
+	//Guards the blocks and every tracker.
+	static std::mutex lock;
+	//Tracker selected by the calling thread. NULL for the process tracker.
+	static thread_local memoryTracker* active;
+
+	/**
+	 * @brief Changes the bytes of a component and updates its peak.
+	 */
+	void change(const std::string& component, size_t oldBytes, size_t newBytes);
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	memoryTracker();
+	/**
+	 * @brief Forgets the blocks still counted here. They are not freed.
+	 */
+	~memoryTracker();
+
+	//Blocks point back at their tracker.
+	memoryTracker(const memoryTracker&) = delete;
+	memoryTracker& operator=(const memoryTracker&) = delete;
+
+	/**
+	 * @brief The tracker for runs without a tracker of their own.
+	 */
+	static memoryTracker* process();
+	/**
+	 * @brief The tracker the calling thread counts new blocks against.
+	 */
+	static memoryTracker* owner() {
+		return (active != NULL) ? active : process();
+	}
+	/**
+	 * @brief Counts the new blocks of the calling thread against a tracker.
+	 * @param tracker The tracker. NULL for the process tracker.
+	 */
+	static void use(memoryTracker* tracker) {
+		active = tracker;
+	}
+
+	/**
+	 * @brief Registers a block.
+	 * @param mem The address of the block.
+	 * @param bytes The size of the block.
+	 * @param component The part of the engine that owns it.
+	 * @param tracker The tracker to count it against. NULL for the tracker of the calling thread.
+	 */
+	static void add(const void* mem, size_t bytes, const std::string& component, memoryTracker* tracker = NULL);
+	/**
+	 * @brief Removes a block. Unknown and NULL addresses are ignored.
+	 * @param mem The address of the block.
+	 */
+	static void remove(const void* mem);
+	/**
+	 * @brief Sets the bytes of a component measured as a whole.
+	 * @param component The part of the engine.
+	 * @param bytes The bytes it holds now.
+	 */
+	void set(const std::string& component, size_t bytes);
+
+	/**
+	 * @brief The bytes a component holds now.
+	 */
+	size_t current(const std::string& component);
+	/**
+	 * @brief The most bytes a component has held.
+	 */
+	size_t peak(const std::string& component);
+	/**
+	 * @brief The bytes held by every component.
+	 */
+	size_t total();
+	/**
+	 * @brief The most bytes held by every component at once.
+	 */
+	size_t peakTotal();
+
+	/**
+	 * @brief Prints current and peak MB of each component.
+	 */
+	void report();
+	/**
+	 * @brief Appends current and peak bytes of each component to a file.
+	 * @param fileName The file to append to.
+	 * @param currentTime The system time.
+	 */
+	void write(std::string fileName, double currentTime);
+
+};
+
+}
+
+#endif // MEMORY_TRACKER_H
@@ -0,0 +1,142 @@
+#ifndef NOISE_QUEUE_H
+#define NOISE_QUEUE_H
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <omp.h>
+#include "config.h"
+#include "philox.h"
+#include "numa.h"
+
+namespace PSim {
+
+/**
+ * @class noiseQueue
+ * @file noiseQueue.h
+ * @brief Double buffered gaussian noise, filled one step ahead.
+ *
+ * The noise for a step does not depend on the forces, so once an integrator
+ * has used the noise for step n it asks for step n + 1. A producer thread,
+ * kept for the life of the queue, fills the back buffer while the system
+ * rebuilds its cells and evaluates the forces. The deviates are the same as
+ * a direct philox fill, so the trajectory does not depend on whether the
+ * producer is used.
+ */
+class noiseQueue {
+
+private:
+
+	uint64_t seed;
+	int n;
+	int width;
+	//Planar buffers are stored by component. See philox::fillGaussianPlanar.
+	bool planar;
+	//Particle id of each row. NULL to key the noise on the row.
+	const int* ids;
+
+	//Fill the next step on a producer thread.
+	bool async;
+	//OpenMP threads given to the producer.
+	int threads;
+
+	double* buffers[2];
+	//Step held by each buffer, and whether the buffer holds anything.
+	uint64_t held[2];
+	bool valid[2];
+	//Buffer handed to the integrator.
+	int front;
+	//Set while the front buffer still holds the noise it was taken with.
+	bool kept;
+
+	//Started by the first prefetch and woken for each one after.
+	std::thread producer;
+	std::mutex lock;
+	//Wakes the producer for a fill, and the owner once it is done.
+	std::condition_variable work;
+	std::condition_variable done;
+	//Set from prefetch until the producer has filled the buffer. Guarded by lock.
+	bool pending;
+	//Set to end the producer.
+	bool stopping;
+	//The fill handed to the producer.
+	int jobBuffer;
+	uint64_t jobStep;
+
+	/**
+	 * @brief Body of the producer thread. Fills each pending buffer until stopped.
+	 */
+	void produce();
+	/**
+	 * @brief Fills a buffer with the noise of a step.
+	 * @param b The buffer.
+	 * @param step The integration step.
+	 */
+	void fill(int b, uint64_t step);
+	void fillInTeam(int b, uint64_t step);
+	//Set when the back buffer must be filled before it is taken. Shared by the team.
+	bool refill;
+	/**
+	 * @brief Waits for the producer to finish the pending fill.
+	 */
+	void wait();
+
+public:
+
+	//Header Version.
+	static const int version = 2;
+
+	/**
+	 * @brief Creates the buffers.
+	 * @param cfg The address of the configuration file reader.
+	 * @param seed The system seed.
+	 * @param n The number of particles.
+	 * @param width The deviates per particle.
+	 * @param planar Store the deviates by component.
+	 */
+	noiseQueue(config* cfg, uint64_t seed, int n, int width, bool planar);
+	~noiseQueue();
+
+	/**
+	 * @brief Gets the noise of a step. Fills it now if it was not prefetched.
+	 * @param step The integration step.
+	 * @return The buffer. Valid until the next call to take.
+	 */
+	const double* take(uint64_t step);
+	/**
+	 * @brief The same as take, called by every thread of an open parallel region.
+	 * A missing step is filled by the whole team.
+	 */
+	const double* takeInTeam(uint64_t step);
+	/**
+	 * @brief Starts filling the noise of a later step.
+	 * @param step The integration step.
+	 */
+	void prefetch(uint64_t step);
+	/**
+	 * @brief Hands back the noise of the last take, so a retried step draws the same deviates.
+	 * Any later step already prefetched is dropped.
+	 * @param step The step to take again.
+	 */
+	void rewind(uint64_t step);
+	/**
+	 * @brief Keys the noise of each row on a particle id.
+	 * @param rowIds The id of each row. Read at every fill.
+	 */
+	void setIds(const int* rowIds) {
+		ids = rowIds;
+	}
+	/**
+	 * @brief Drops any prefetched noise. Used when the particles change rows.
+	 */
+	void invalidate() {
+		wait();
+		valid[0] = false;
+		valid[1] = false;
+		kept = false;
+	}
+
+};
+
+}
+
+#endif // NOISE_QUEUE_H
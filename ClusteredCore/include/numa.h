@@ -0,0 +1,102 @@
+#ifndef NUMA_H
+#define NUMA_H
+#include <omp.h>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "config.h"
+#include "memoryTracker.h"
+
+namespace PSim {
+
+/**
+ * @class numa
+ * @file numa.h
+ * @brief Thread placement and NUMA aware allocation of the particle arrays.
+ *
+ * Linux places a page on the node of the thread that first writes it. Arrays
+ * from allocate are zeroed by the OMP team with a static schedule, so each
+ * page lands on the node of the thread whose particles it holds. Large arrays
+ * are aligned to a huge page and marked for transparent huge pages.
+ *
+ * Settings (settings.cfg):
+ * ompThreads - Threads in the OMP team. 0 leaves the runtime default.
+ * threadPinning - none, compact (fill one socket first) or spread (alternate sockets).
+ * hugePages - 1 to request transparent huge pages for large arrays.
+ */
+class numa {
+
+private:
+
+	//Arrays at least this large are backed by huge pages.
+	static const size_t hugePageSize = 2 * 1024 * 1024;
+	static bool hugePages;
+
+	/**
+	 * @brief Pins each thread of the OMP team to one core.
+	 * @param spread True to alternate sockets. False to fill one socket first.
+	 */
+	static void pinThreads(bool spread);
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	/**
+	 * @brief Sets the OMP team size and thread placement from the configuration.
+	 * Call before any particle arrays are allocated.
+	 * @param cfg The address of the configuration file reader.
+	 */
+	static void configure(config* cfg);
+	/**
+	 * @brief Restores the affinity the process started with on the calling thread.
+	 * Helper threads created by a pinned thread would otherwise share its core.
+	 */
+	static void unpin();
+
+	/**
+	 * @brief Aligned memory, huge page backed when large. Not touched.
+	 * @param bytes The size of the block.
+	 * @param component The owner the block is counted against in the memoryTracker.
+	 * @param tracker The tracker to count it in. NULL for the tracker of the calling thread.
+	 * @return The block. Free with release.
+	 */
+	static void* reserve(size_t bytes, const char* component = "other", memoryTracker* tracker = NULL);
+	/**
+	 * @brief Frees memory from reserve or allocate.
+	 */
+	static void release(void* mem) {
+		memoryTracker::remove(mem);
+		free(mem);
+	}
+
+	/**
+	 * @brief Zeroes an array with the same static split as the particle loops.
+	 * @param mem The array.
+	 * @param n The number of elements.
+	 */
+	template<typename T> static void touch(T* mem, size_t n) {
+		long count = (long) n;
+#pragma omp parallel for schedule(static) if (count > 4096)
+		for (long i = 0; i < count; i++) {
+			mem[i] = T();
+		}
+	}
+	/**
+	 * @brief A zeroed array, first touched by the threads that use it.
+	 * @param n The number of elements.
+	 * @param component The owner the array is counted against.
+	 * @return The array. Free with release.
+	 */
+	template<typename T> static T* allocate(size_t n, const char* component = "other") {
+		T* mem = (T*) reserve(n * sizeof(T), component);
+		touch(mem, n);
+		return mem;
+	}
+
+};
+
+}
+
+#endif // NUMA_H
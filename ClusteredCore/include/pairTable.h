@@ -0,0 +1,101 @@
+#ifndef PAIR_TABLE_H
+#define PAIR_TABLE_H
+#include "config.h"
+#include <vector>
+
+namespace PSim {
+
+/**
+ * @class pairTable
+ * @file pairTable.h
+ * @brief Symmetric table of a force constant for each pair of species.
+ *
+ * Reads 'key' as the default for every pair and 'key_i_j' (or 'key_j_i') as the
+ * override for species i and j. With one species the table holds only 'key'.
+ */
+class pairTable {
+
+private:
+
+	int nSpecies;
+	std::vector<double> values;
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	/**
+	 * @brief Creates a single species table.
+	 */
+	pairTable() : nSpecies(1), values(1, 0.0) {
+	}
+	/**
+	 * @brief Creates a table with every pair set to one value.
+	 * @param n The number of species.
+	 * @param def The value of every pair.
+	 */
+	pairTable(int n, double def) : nSpecies(n), values(n * n, def) {
+	}
+	/**
+	 * @brief Reads a table from the config file.
+	 * @param cfg The config file reader.
+	 * @param key The name of the constant.
+	 * @param def The default if the key is missing.
+	 * @param n The number of species.
+	 */
+	pairTable(config* cfg, std::string key, double def, int n) : nSpecies(n), values(n * n, 0.0) {
+		double base = cfg->getParam<double>(key, def);
+		for (int i = 0; i < n; i++) {
+			for (int j = i; j < n; j++) {
+				std::string ij = key + "_" + std::to_string(i) + "_" + std::to_string(j);
+				std::string ji = key + "_" + std::to_string(j) + "_" + std::to_string(i);
+				double val = base;
+				if (cfg->containsKey(ij)) {
+					val = cfg->getParam<double>(ij, base);
+				} else if (cfg->containsKey(ji)) {
+					val = cfg->getParam<double>(ji, base);
+				}
+				set(i, j, val);
+			}
+		}
+	}
+
+	/**
+	 * @brief Gets the constant for a pair of species.
+	 * @param i,j The species of the pair.
+	 */
+	double operator()(int i, int j) const {
+		return values[(i * nSpecies) + j];
+	}
+	/**
+	 * @brief Sets the constant for a pair of species.
+	 * @param i,j The species of the pair.
+	 * @param val The new value.
+	 */
+	void set(int i, int j, double val) {
+		values[(i * nSpecies) + j] = val;
+		values[(j * nSpecies) + i] = val;
+	}
+	/**
+	 * @brief The largest constant in the table.
+	 */
+	double max() const {
+		double big = values[0];
+		for (unsigned int k = 1; k < values.size(); k++) {
+			big = (values[k] > big) ? values[k] : big;
+		}
+		return big;
+	}
+	/**
+	 * @brief Gets the number of species.
+	 */
+	int getNSpecies() const {
+		return nSpecies;
+	}
+
+};
+
+}
+
+#endif // PAIR_TABLE_H
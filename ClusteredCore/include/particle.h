@@ -1,6 +1,7 @@
 #ifndef PARTICLE_H
 #define PARTICLE_H
 #include "utilities.h"
+#include "particleStore.h"
 
 namespace PSim {
 
@@ -9,7 +10,10 @@ namespace PSim {
  * @author Sawyer Hopkins
  * @date 06/27/15
  * @file particle.h
- * @brief
+ * @brief A view onto one slot of a particleStore.
+ *
+ * Positions, velocities, forces, radius and mass live in the store. The
+ * particle keeps the data that is not streamed every step.
  */
 class particle {
 
@@ -22,23 +26,18 @@ private:
 	//The particle identifier.
 	int name;
 
-	//Contains the current spacial information for x,y,z cordinates.
-	type3<double> pos;
+	//Holds the position, velocity, force, radius and mass.
+	particleStore* store;
+	//Index of the particle in the store.
+	int slot;
+	//Set when the particle was made on its own and owns a one slot store.
+	bool ownsStore;
 
-	//Contains the previous spacial information for x,y,z cordinates.
-	type3<double> pos0;
+	//The species of the particle.
+	int species;
 
-	//Contains the velocity information for x,y,z cordinates.
-	type3<double> vel;
-
-	//Contains the current force information for the x,y,z cordinates.
-	type3<double> frc;
-
-	//Contains the previous force information for the x,y,z cordinates.
-	type3<double> frc0;
-
-	//Contains the radius and mass of each particle.
-	double r,m;
+	//Frozen particles are never integrated.
+	bool frozen;
 
 	//Contains the current cell identification.
 	type3<int> cll;
@@ -51,7 +50,7 @@ private:
 public:
 
 	//Header Version.
-	static const int version = 1;
+	static const int version = 3;
 
 	/********************************************//**
 	 *--------------SYSTEM CONSTRUCTION---------------
@@ -64,6 +63,17 @@ public:
 	 * @return
 	 */
 	particle(int pid);
+	/**
+	 * @brief Creates a particle in a slot of a shared store. The slot is cleared.
+	 * @param pid The name of the particle.
+	 * @param data The store.
+	 * @param index The slot in the store.
+	 * @return
+	 */
+	particle(int pid, particleStore* data, int index);
+	//Views are not copied.
+	particle(const particle&) = delete;
+	particle& operator=(const particle&) = delete;
 	/**
 	 * @brief Removes particle resources from memory.
 	 * @return Nothing.
@@ -80,21 +90,21 @@ public:
 	 * @return  exposes private variable x.
 	 */
 	const double getX() const {
-		return pos.x;
+		return store->x[slot];
 	}
 	/**
 	 * @brief Get the Y position
 	 * @return  exposes private variable y.
 	 */
 	const double getY() const {
-		return pos.y;
+		return store->y[slot];
 	}
 	/**
 	 * @brief Get the Z position
 	 * @return  exposes private variable z.
 	 */
 	const double getZ() const {
-		return pos.z;
+		return store->z[slot];
 	}
 
 	//Getters for previous position.
@@ -104,21 +114,21 @@ public:
 	 * @return  exposes private variable x0.
 	 */
 	const double getX0() const {
-		return pos0.x;
+		return store->x0[slot];
 	}
 	/**
 	 * @brief Get the previous Y position
 	 * @return  exposes private variable y0.
 	 */
 	const double getY0() const {
-		return pos0.y;
+		return store->y0[slot];
 	}
 	/**
 	 * @brief Get the previous X position
 	 * @return  exposes private variable z0.
 	 */
 	const double getZ0() const {
-		return pos0.z;
+		return store->z0[slot];
 	}
 
 	//Getters for velocity.
@@ -128,21 +138,21 @@ public:
 	 * @return  exposes private variable x.
 	 */
 	const double getVX() const {
-		return vel.x;
+		return store->vx[slot];
 	}
 	/**
 	 * @brief Get the y velocity.
 	 * @return  exposes private variable y.
 	 */
 	const double getVY() const {
-		return vel.y;
+		return store->vy[slot];
 	}
 	/**
 	 * @brief Get the z velocity.
 	 * @return  exposes private variable z.
 	 */
 	const double getVZ() const {
-		return vel.z;
+		return store->vz[slot];
 	}
 
 	//Getters for current force.
@@ -152,21 +162,21 @@ public:
 	 * @return  exposes private variable fx.
 	 */
 	const double getFX() const {
-		return frc.x;
+		return store->force[3*slot];
 	}
 	/**
 	 * @brief Get the current y force.
 	 * @return  exposes private variable fy.
 	 */
 	const double getFY() const {
-		return frc.y;
+		return store->force[3*slot+1];
 	}
 	/**
 	 * @brief Get the current z force.
 	 * @return  exposes private variable fz.
 	 */
 	const double getFZ() const {
-		return frc.z;
+		return store->force[3*slot+2];
 	}
 
 	//Getters for previous force.
@@ -176,21 +186,21 @@ public:
 	 * @return  exposes private variable fx0.
 	 */
 	const double getFX0() const {
-		return frc0.x;
+		return store->force0[3*slot];
 	}
 	/**
 	 * @brief Get the previous y force.
 	 * @return  exposes private variable fy0.
 	 */
 	const double getFY0() const {
-		return frc0.y;
+		return store->force0[3*slot+1];
 	}
 	/**
 	 * @brief Get the previous z force.
 	 * @return  exposes private variable fz0.
 	 */
 	const double getFZ0() const {
-		return frc0.z;
+		return store->force0[3*slot+2];
 	}
 
 	//Getters for containing cell.
@@ -224,14 +234,28 @@ public:
 	 * @return  exposes private variable r.
 	 */
 	const double getRadius() const {
-		return r;
+		return store->radius[slot];
 	}
 	/**
 	 * @brief Get the mass of the particle.
 	 * @return  exposes private variable m.
 	 */
 	const double getMass() const {
-		return m;
+		return store->mass[slot];
+	}
+	/**
+	 * @brief Get the species of the particle.
+	 * @return  exposes private variable species.
+	 */
+	const int getSpecies() const {
+		return species;
+	}
+	/**
+	 * @brief Check if the particle is held in place.
+	 * @return  exposes private variable frozen.
+	 */
+	const bool isFrozen() const {
+		return frozen;
 	}
 	/**
 	 * @brief Get the name of the particle.
@@ -251,7 +275,7 @@ public:
 	 * @brief Get the interacting particles.
 	 * @return
 	 */
-	const std::vector<particle*> getInteractions() const {
+	const std::vector<particle*>& getInteractions() const {
 		return interactions;
 	}
 	/**
@@ -297,26 +321,46 @@ public:
 	 * @param boxSize The size of the system box.
 	 */
 	void setPos(type3<double>* pos, int boxSize);
+	/**
+	 * @brief Sets the current and previous position directly. The caller handles PBC.
+	 * @param newPos The new position.
+	 * @param newPos0 The previous position.
+	 */
+	void setPosRaw(const type3<double>& newPos, const type3<double>& newPos0) {
+		store->x[slot] = newPos.x;
+		store->y[slot] = newPos.y;
+		store->z[slot] = newPos.z;
+		store->x0[slot] = newPos0.x;
+		store->y0[slot] = newPos0.y;
+		store->z0[slot] = newPos0.z;
+	}
+	/**
+	 * @brief Moves the view to another slot. The store must already hold the particle there.
+	 * @param index The new slot.
+	 */
+	void setSlot(int index) {
+		slot = index;
+	}
 	/**
 	 * @brief Set the x velocity.
 	 * @param val The velocity to set.
 	 */
 	void setVX(double val) {
-		vel.x = val;
+		store->vx[slot] = val;
 	}
 	/**
 	 * @brief Set the y velocity.
 	 * @param val The velocity to set.
 	 */
 	void setVY(double val) {
-		vel.y = val;
+		store->vy[slot] = val;
 	}
 	/**
 	 * @brief Set the z velocity.
 	 * @param val The velocity to set.
 	 */
 	void setVZ(double val) {
-		vel.z = val;
+		store->vz[slot] = val;
 	}
 	/**
 	 * @brief Adds the the current value of force.
@@ -327,6 +371,10 @@ public:
 	void updateForce(type3<double>* frc, particle* p, bool countPair = true);
 
 	void setForce(double* val);
+	/**
+	 * @brief Resets the interacting particles and the coordination number.
+	 */
+	void clearInteractions();
 	/**
 	 * @brief Calculates the potential via force integration.
 	 */
@@ -349,14 +397,28 @@ public:
 	 * @param val Radius value.
 	 */
 	void setRadius(double val) {
-		r = val;
+		store->radius[slot] = val;
 	}
 	/**
 	 * @brief Sets the mass of the particle.
 	 * @param val Mass value.
 	 */
 	void setMass(double val) {
-		m = val;
+		store->mass[slot] = val;
+	}
+	/**
+	 * @brief Sets the species of the particle.
+	 * @param val Species index.
+	 */
+	void setSpecies(int val) {
+		species = val;
+	}
+	/**
+	 * @brief Holds the particle in place or releases it.
+	 * @param val True to freeze the particle.
+	 */
+	void setFrozen(bool val) {
+		frozen = val;
 	}
 	/**
 	 * @brief For setting up interaction table.
@@ -373,7 +435,7 @@ public:
 	 * @brief Writes the position of the particle to the console.
 	 */
 	void writePosition() {
-		chatterBox.consoleMessage(tos(pos.x) + ", " + tos(pos.y) + ", " + tos(pos.z));
+		chatterBox.consoleMessage(tos(getX()) + ", " + tos(getY()) + ", " + tos(getZ()));
 	}
 
 };
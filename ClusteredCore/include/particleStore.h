@@ -0,0 +1,92 @@
+#ifndef PARTICLE_STORE_H
+#define PARTICLE_STORE_H
+#include <algorithm>
+
+namespace PSim {
+
+/**
+ * @class particleStore
+ * @file particleStore.h
+ * @brief Structure of arrays holding the numeric data of every particle.
+ *
+ * Each array starts on a 64 byte boundary and is first touched by the threads
+ * that work on it. The particle class is a view onto one slot, so plugins and
+ * analysis keep the particle interface while the system and integrators
+ * stream over the arrays.
+ */
+class particleStore {
+
+private:
+
+	//Number of slots.
+	int capacity;
+	//One aligned block backs every array.
+	double* block;
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	//Current position.
+	double* x;
+	double* y;
+	double* z;
+	//Previous position.
+	double* x0;
+	double* y0;
+	double* z0;
+	//Velocity.
+	double* vx;
+	double* vy;
+	double* vz;
+	//Radius and mass.
+	double* radius;
+	double* mass;
+	//Particle id of each slot. Keys the noise, so it follows a particle when slots are reordered.
+	int* id;
+
+	//Current and previous force, three per particle in particle order.
+	//Kept interleaved because force plugins write particleForce[3*i] in place.
+	double* force;
+	double* force0;
+
+	/**
+	 * @brief Creates zeroed storage.
+	 * @param n The number of particles.
+	 * @param component The owner the memory is counted against.
+	 */
+	particleStore(int n, const char* component = "particleStore");
+	~particleStore();
+
+	/**
+	 * @brief The number of particles held.
+	 */
+	int size() const {
+		return capacity;
+	}
+	/**
+	 * @brief Zeroes one slot.
+	 * @param i The particle index.
+	 */
+	void clear(int i);
+	/**
+	 * @brief Moves every slot to a new place.
+	 * @param order order[k] is the old slot of the particle that moves to slot k.
+	 * @param scratch Work space of 3 * size() doubles.
+	 */
+	void permute(const int* order, double* scratch);
+	void permuteInTeam(const int* order, double* scratch);
+	/**
+	 * @brief The current forces become the previous forces.
+	 * The old previous buffer becomes the target of the next force pass.
+	 */
+	void swapForces() {
+		std::swap(force, force0);
+	}
+
+};
+
+}
+
+#endif // PARTICLE_STORE_H
@@ -0,0 +1,162 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+#include <stdint.h>
+#include <cmath>
+#include <cstddef>
+
+namespace PSim {
+
+/**
+ * @class philox
+ * @file philox.h
+ * @brief Counter based Philox4x32-10 random numbers.
+ *
+ * Every draw is a pure function of (seed, particle, step, stream). There is
+ * no generator state, so the noise on a particle does not depend on thread
+ * count, scheduling or the order particles are visited in.
+ * See SALMON ET AL. 2011.
+ */
+class philox {
+
+private:
+
+	//Round multipliers and key schedule.
+	static const uint32_t M0 = 0xD2511F53;
+	static const uint32_t M1 = 0xCD9E8D57;
+	static const uint32_t W0 = 0x9E3779B9;
+	static const uint32_t W1 = 0xBB67AE85;
+
+	//Scalar words keep the state in registers, so loops over particles vectorize.
+	static inline void round(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1) {
+		uint64_t p0 = (uint64_t) M0 * c0;
+		uint64_t p1 = (uint64_t) M1 * c2;
+		uint32_t hi0 = (uint32_t) (p0 >> 32);
+		uint32_t hi1 = (uint32_t) (p1 >> 32);
+		c0 = hi1 ^ c1 ^ k0;
+		c2 = hi0 ^ c3 ^ k1;
+		c1 = (uint32_t) p1;
+		c3 = (uint32_t) p0;
+	}
+
+	/**
+	 * @brief Shared body of the buffer fills.
+	 * @param rowStride The distance between particles in the buffer.
+	 * @param laneStride The distance between deviates of one particle.
+	 * @param ids The counter of each row. NULL to use the row index.
+	 */
+	static void fill(uint64_t seed, uint64_t step, int n, int width, double* out, int rowStride, int laneStride, const int* ids);
+	static void fillInTeam(uint64_t seed, uint64_t step, int n, int width, double* out, int rowStride, int laneStride, const int* ids);
+
+	/**
+	 * @brief Maps 32 random bits to (0,1].
+	 */
+	static inline double uniform(uint32_t x) {
+		return (x + 0.5) * 2.3283064365386963e-10;
+	}
+
+	/**
+	 * @brief Box-Muller on one pair of random words.
+	 * @param r The word for the radius.
+	 * @param a The word for the angle.
+	 * @param dCos,dSin The two deviates.
+	 */
+	static inline void boxMuller(uint32_t r, uint32_t a, double& dCos, double& dSin) {
+		const double twoPi = 6.283185307179586;
+		double rad = std::sqrt(-2.0 * std::log(uniform(r)));
+		double ang = twoPi * uniform(a);
+		dCos = rad * std::cos(ang);
+		dSin = rad * std::sin(ang);
+	}
+
+	/**
+	 * @brief Box-Muller on two pairs of random words.
+	 * @param b0,b1,b2,b3 The output of one Philox draw.
+	 * @param out The four deviates.
+	 */
+	static inline void boxMuller(uint32_t b0, uint32_t b1, uint32_t b2, uint32_t b3, double* out) {
+		boxMuller(b0, b1, out[0], out[1]);
+		boxMuller(b2, b3, out[2], out[3]);
+	}
+
+public:
+
+	//Header Version.
+	static const int version = 1;
+
+	/**
+	 * @brief Philox4x32-10 bijection.
+	 * @param ctr The counter. Replaced by the random output.
+	 * @param seedKey The key.
+	 */
+	static inline void generate(uint32_t* ctr, const uint32_t* seedKey) {
+		generate(ctr[0], ctr[1], ctr[2], ctr[3], seedKey[0], seedKey[1]);
+	}
+	/**
+	 * @brief Philox4x32-10 bijection on scalar words.
+	 * @param c0,c1,c2,c3 The counter. Replaced by the random output.
+	 * @param k0,k1 The key.
+	 */
+	static inline void generate(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1) {
+		for (int r = 0; r < 9; r++) {
+			round(c0, c1, c2, c3, k0, k1);
+			k0 += W0;
+			k1 += W1;
+		}
+		round(c0, c1, c2, c3, k0, k1);
+	}
+
+	/**
+	 * @brief Four standard normal deviates.
+	 * @param seed The system seed.
+	 * @param id The particle index.
+	 * @param step The integration step.
+	 * @param stream Separates independent draws in one step.
+	 * @param out The four deviates.
+	 */
+	static inline void gaussian4(uint64_t seed, uint32_t id, uint64_t step, uint32_t stream, double* out) {
+		uint32_t ctr[4] = {id, (uint32_t) step, (uint32_t) (step >> 32), stream};
+		uint32_t key[2] = {(uint32_t) seed, (uint32_t) (seed >> 32)};
+		generate(ctr, key);
+		boxMuller(ctr[0], ctr[1], ctr[2], ctr[3], out);
+	}
+
+	/**
+	 * @brief Fills a buffer with the deviates of every particle for one step.
+	 *
+	 * Particle i gets out[width*i] to out[width*i + width - 1]. Deviate c is
+	 * lane c%4 of gaussian4 with stream c/4, so the buffer matches per particle
+	 * draws exactly. The Philox rounds run over blocks of particles so the
+	 * integer work vectorizes, and the blocks are shared across threads.
+	 * @param seed The system seed.
+	 * @param step The integration step.
+	 * @param n The number of particles.
+	 * @param width The deviates per particle.
+	 * @param out The n * width buffer.
+	 * @param ids The particle id of each row, so the noise follows a particle when storage is reordered. NULL to use the row index.
+	 */
+	static void fillGaussian(uint64_t seed, uint64_t step, int n, int width, double* out, const int* ids = NULL);
+	/**
+	 * @brief Fills a buffer with the same deviates as fillGaussian, stored by component.
+	 *
+	 * Deviate c of particle i is out[(c * n) + i]. Each component is a contiguous
+	 * plane, so SoA kernels read the noise with unit stride.
+	 * @param seed The system seed.
+	 * @param step The integration step.
+	 * @param n The number of particles.
+	 * @param width The deviates per particle.
+	 * @param out The width * n buffer.
+	 * @param ids The particle id of each row. NULL to use the row index.
+	 */
+	static void fillGaussianPlanar(uint64_t seed, uint64_t step, int n, int width, double* out, const int* ids = NULL);
+	/**
+	 * @brief The same fills, called by every thread of an open parallel region.
+	 * The blocks are shared with the team instead of a new one.
+	 */
+	static void fillGaussianInTeam(uint64_t seed, uint64_t step, int n, int width, double* out, const int* ids = NULL);
+	static void fillGaussianPlanarInTeam(uint64_t seed, uint64_t step, int n, int width, double* out, const int* ids = NULL);
+
+};
+
+}
+
+#endif // PHILOX_H
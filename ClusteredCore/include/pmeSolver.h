@@ -0,0 +1,132 @@
+#ifndef PME_SOLVER_H
+#define PME_SOLVER_H
+#include "fft.h"
+#include "structs/systemState.h"
+
+namespace PSim {
+
+/**
+ * @class pmeSolver
+ * @file pmeSolver.h
+ * @brief Smooth particle mesh ewald summation for long range electrostatics.
+ *
+ * Splits the coulomb interaction into a short range erfc term, which the force
+ * evaluates during its cell traversal, and a reciprocal term solved on an FFT grid.
+ * See ESSMANN ET AL. 1995.
+ */
+class pmeSolver {
+
+private:
+
+	//Ewald splitting parameter.
+	double alpha;
+	//Energy scale of the coulomb interaction (kT * bjerrum length).
+	double prefactor;
+	//Order of the cardinal B-spline.
+	int order;
+	//Box size the influence function was built for.
+	int boxSize;
+	//Number of particles the force buffer was built for.
+	int nParticles;
+	//Requested mesh points per dimension. Zero or less picks from alpha.
+	int requestedGrid;
+
+	//Transform and grid.
+	fft3d* transform;
+	std::complex<double>* grid;
+	//Product of the B-spline moduli and the reciprocal green's function.
+	double* influence;
+	//Reciprocal force on each sorted particle.
+	double* recipForce;
+	//Spline weights and derivatives of each sorted particle, order per dimension.
+	double* splineTheta;
+	double* splineDTheta;
+	//Mesh point of each sorted particle the weights count down from, per dimension.
+	int* splineBase;
+	//Charge mesh of each thread, summed into the grid after spreading.
+	double* threadGrid;
+	//Number of threads the charge meshes were built for.
+	int gridThreads;
+
+	/**
+	 * @brief Cardinal B-spline of the solver order.
+	 * @param n The order of the spline.
+	 * @param x The position on the spline.
+	 */
+	static double bSpline(int n, double x);
+	/**
+	 * @brief Creates the mesh and transform for a new box.
+	 * @param L The size of the system box.
+	 */
+	void buildGrid(int L);
+	/**
+	 * @brief Rebuilds the influence function for a new box.
+	 * @param L The size of the system box.
+	 */
+	void buildInfluence(int L);
+	/**
+	 * @brief Spline weights and derivatives for a fractional coordinate.
+	 * Built up from the linear spline by the cardinal B-spline recursion.
+	 * @param w The fractional part of the scaled coordinate.
+	 * @param theta Weights M(w+j).
+	 * @param dTheta Derivatives M'(w+j).
+	 */
+	void splineWeights(double w, double* theta, double* dTheta);
+
+public:
+
+	//Header Version.
+	static const int version = 2;
+
+	//Largest supported spline order.
+	static const int maxOrder = 8;
+
+	/**
+	 * @brief Creates the solver.
+	 * @param gridSize The number of mesh points per dimension. Rounded up to a power of two.
+	 * Zero or less picks a mesh spacing of 0.8 / alpha once the box size is known.
+	 * @param splineOrder The order of the B-spline interpolation.
+	 * @param ewaldAlpha The ewald splitting parameter.
+	 * @param energyScale The coulomb energy scale (kT * bjerrum length).
+	 */
+	pmeSolver(int gridSize, int splineOrder, double ewaldAlpha, double energyScale);
+	~pmeSolver();
+
+	/**
+	 * @brief Solves the reciprocal force on every sorted particle.
+	 * @param sortedParticles The cell sorted particle positions.
+	 * @param charge The valence of each particle.
+	 * @param state The system state.
+	 */
+	void computeForces(double* sortedParticles, double charge, systemState* state);
+
+	/**
+	 * @brief The magnitude of the real space force between two unit charges.
+	 * @param r The distance between the particles.
+	 * @return Positive for repulsive.
+	 */
+	double realSpaceForce(double r) const {
+		double ar = alpha * r;
+		return prefactor * ((std::erfc(ar) / (r * r)) + (1.1283791670955126 * alpha * std::exp(-ar * ar) / r));
+	}
+
+	/**
+	 * @brief The reciprocal force on a sorted particle.
+	 * @param index The sorted index of the particle.
+	 */
+	const double* getForce(int index) const {
+		return &(recipForce[3 * index]);
+	}
+
+	/**
+	 * @brief Gets the number of mesh points per dimension.
+	 */
+	int getGridSize() const {
+		return (transform == NULL) ? 0 : transform->getSize();
+	}
+
+};
+
+}
+
+#endif // PME_SOLVER_H
@@ -0,0 +1,47 @@
+#ifndef CELL_BINS_H
+#define CELL_BINS_H
+#include <cmath>
+#include <vector>
+
+namespace PSim {
+
+/**
+ * @struct cellBins
+ * @brief Positions and cell keys written by the integrator as it moves each particle.
+ *
+ * The system rebuilds its cell tables from these flat arrays rather than
+ * reading every particle again. An integrator that does not fill them leaves
+ * filled unset and the system hashes the particles itself.
+ */
+struct cellBins {
+	//Wrapped position and radius of each particle, by particle index.
+	std::vector<double> pos;
+	//Cell key hash*nSpecies+species of each particle, by particle index.
+	std::vector<int> key;
+	//Species of each particle, by particle index.
+	std::vector<int> species;
+	int cellSize;
+	int cellScale;
+	int nSpecies;
+	//Set once every mobile particle has been binned for the step.
+	bool filled;
+
+	/**
+	 * @brief Bins a particle at its new position.
+	 * @param i The particle index.
+	 * @param x,y,z The wrapped position.
+	 */
+	inline void bin(int i, double x, double y, double z) {
+		int cx = floor(x / cellSize);
+		int cy = floor(y / cellSize);
+		int cz = floor(z / cellSize);
+		int hash = cx + (cellScale * cy) + (cellScale * cellScale * cz);
+		key[i] = (hash * nSpecies) + species[i];
+		pos[4*i] = x;
+		pos[4*i+1] = y;
+		pos[4*i+2] = z;
+	}
+};
+
+}
+#endif // CELL_BINS_H
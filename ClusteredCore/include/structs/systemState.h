@@ -1,11 +1,21 @@
 #ifndef SYSTEM_STATE_H
 #define SYSTEM_STATE_H
 #include "type3.h"
+#include "cellBins.h"
 
 namespace PSim {
 
+class particleStore;
+
+//Start and end of a run in cellStartEnd that holds no particles.
+const int emptyCell = -1;
+
 struct systemState {
 	int nParticles;
+	//Particles in a cell are sorted by species. Cell runs are indexed by hash*nSpecies+species.
+	int nSpecies;
+	//Frozen particles fill the tail of the sorted arrays. Their runs start at cellScale^3*nSpecies.
+	int nFrozen;
 	double concentration;
 	int boxSize;
 	int cellSize;
@@ -15,7 +25,29 @@ struct systemState {
 	double dTime;
 	int seed;
 	int outputFreq;
+	//Time between snapshots when the time step is adaptive. Zero for a fixed time step.
+	double outputInterval;
 	double endTime;
+	//Filled by the integrator for the next cell rebuild. NULL if the caller does not bin.
+	cellBins* bins;
+	//Numeric particle data. NULL if the particles are not in a shared store.
+	particleStore* store;
+
+	/**
+	 * @brief The number of runs to visit in each cell.
+	 */
+	int runsPerCell() const {
+		return (nFrozen > 0) ? 2 * nSpecies : nSpecies;
+	}
+	/**
+	 * @brief Gets the index of a run in cellStartEnd.
+	 * @param hash The cell hash.
+	 * @param k The run in the cell. Runs past nSpecies hold the frozen particles.
+	 */
+	int runIndex(int hash, int k) const {
+		return (k < nSpecies) ? (hash * nSpecies) + k
+				: (cellScale * cellScale * cellScale * nSpecies) + (hash * nSpecies) + (k - nSpecies);
+	}
 };
 
 }
@@ -1,7 +1,11 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 #include "integrator.h"
+#include "hydroIntegrator.h"
+#include "ermakIntegrator.h"
+#include "baoabIntegrator.h"
 #include "analysisManager.h"
+#include "arena.h"
 
 using namespace std;
 
@@ -28,14 +32,74 @@ private:
 	//Settings flags
 	double cycleHour;
 	int seedSize;
-
-	//System entities.
+	bool freezeSeed;
+
+	//Adaptive time step control.
+	bool adaptiveStep;
+	//Limits of the time step.
+	double dtMin;
+	double dtMax;
+	//Reject a step that brings a pair closer than this fraction of contact.
+	double stepMinGap;
+	//Only grow the step while every pair is further than this fraction of contact.
+	double stepSafeGap;
+	//Limit the step so no force carries a particle further than this.
+	double stepMaxDrift;
+	//Reject a step that leaves the kinetic temperature this fraction over the target.
+	double stepMaxHeat;
+	//Closest pair and heat over the target after the last accepted step.
+	double lastGap;
+	double lastHeat;
+	//Steps spent over the heat limit, and the heat when they began.
+	int hotSteps;
+	double hotHeat;
+	//Factors to shrink and grow the time step.
+	double stepShrink;
+	double stepGrow;
+	//Quiet steps needed before the time step grows.
+	int stepGrowAfter;
+	//The step the controller wants. Trimmed to land on snapshot times.
+	double dtTarget;
+	double nextSnapshot;
+	int quietSteps;
+	int rejectedSteps;
+	//Accepted steps and the time of the last completion estimate.
+	int cycleCount;
+	double lastEstimate;
+	//Positions and velocities before a trial step.
+	std::vector<double> savedParticles;
+
+	//Species properties.
+	std::vector<int> speciesCount;
+	std::vector<double> speciesRadius;
+	std::vector<double> speciesMass;
+	std::vector<bool> speciesFrozen;
+
+	//System entities. Kept in storage order, which follows the cells once reordered.
 	particle** particles;
+	//The same particles in id order, for analysis and output.
+	std::vector<particle*> particlesById;
+	//Steps between reorders of the particle storage. Zero to never reorder.
+	int reorderFreq;
+	//Numeric data of every particle. The particles are views onto it.
+	particleStore* store;
+	//Holds the particle objects and the particle table. Slot i of particleSlots is particle id i.
+	arena particlePool{"particlePool"};
+	particle* particleSlots;
+	//Scratch that lives for one step. Reset at the start of each step.
+	arena stepScratch{"stepScratch"};
+	//Tracker this system's memory is counted in.
+	memoryTracker* memory;
 	//Particle entities
+	//The table index of every particle that is not frozen.
+	std::vector<int> mobileParticles;
 	vector<tuple<int,int>> particleHashIndex;
+	//Merge buffer for sorting the hash table.
+	vector<tuple<int,int>> sortSpace;
+	//Particle positions and cell keys written by the integrator.
+	cellBins bins;
 	vector<tuple<int,int>> cellStartEnd;
 	double* sortedParticles;
-	double* particleForce;
 
 	//System integrator.
 	PSim::IIntegrator* integrator;
@@ -51,6 +115,13 @@ private:
 	 * @param m The mass of the particles.
 	 */
 	void initParticles(double r, double m);
+	/**
+	 * @brief Reads the number, radius and mass of each species.
+	 * @param cfg The config file reader.
+	 * @param r The default radius of the particles.
+	 * @param m The default mass of the particles.
+	 */
+	void initSpecies(config* cfg, double r, double m);
 	/**
 	 * @brief Creates a maxwell distribution of velocities for the system temperature.
 	 * @param gen The random generator the initalize particles.
@@ -82,11 +153,135 @@ private:
 	 ***********************************************/
 
 	/**
-	 * @brief Updates the cells that the particles are located in.
+	 * @brief Makes the new forces current and resets the interaction lists.
 	 * @return
 	 */
 	void pushParticleForce();
+	void pushParticleForceInTeam();
 	void iterateParticleInteractions(int index, int hash);
+	/**
+	 * @brief Gets the cell hash of a particle.
+	 * @param i The particle index.
+	 */
+	int cellHash(int i);
+	/**
+	 * @brief Sets the start and end of each run from a sorted range of the hash table.
+	 * @param first,last The range of sorted particles.
+	 */
+	void linkCells(int first, int last);
+	void linkCellsInTeam(int first, int last);
+	/**
+	 * @brief Bins the frozen particles behind the mobile particles.
+	 * These runs are never cleared, so they are built only once.
+	 */
+	void freezeCells();
+	/**
+	 * @brief Moves every particle array into the order of the current cell table.
+	 * Particles that share a cell then sit together in memory for the integrator and the force loop.
+	 */
+	void permuteParticles() {
+#pragma omp parallel
+		permuteParticlesInTeam();
+	}
+	void permuteParticlesInTeam();
+	//Step scratch of a permute, shared by the team.
+	int* permuteOrder;
+	double* permuteSpace;
+	particle** permuteMoved;
+	int* permuteSpecies;
+	/********************************************//**
+	 *--------------ADAPTIVE TIME STEP---------------
+	 ***********************************************/
+
+	/**
+	 * @brief Reads the step controller settings.
+	 * @param cfg The config file reader.
+	 */
+	void initStepControl(config* cfg);
+	/**
+	 * @brief Takes trial steps until one is accepted, then adjusts the time step.
+	 * The step is first limited so the current forces cannot carry a particle too far.
+	 * A trial is rejected if it closes a pair too far or heats the system past the target.
+	 */
+	void adaptiveTimeStep();
+	/**
+	 * @brief Sets the time step of the system and integrator.
+	 * @param dt The new time step.
+	 */
+	void changeTimeStep(double dt);
+	/**
+	 * @brief The smallest pair separation over contact distance, r / (ri + rj).
+	 * Pairs of frozen particles are skipped.
+	 */
+	double minimumGap();
+	/**
+	 * @brief The furthest any force carries a particle in one step.
+	 */
+	double maximumDrift();
+	/**
+	 * @brief The kinetic temperature of the mobile particles.
+	 */
+	double kineticTemperature();
+	/**
+	 * @brief Saves the positions and velocities before a trial step.
+	 */
+	void saveParticles();
+	/**
+	 * @brief Returns the particles to their saved positions and velocities.
+	 */
+	void restoreParticles();
+	/**
+	 * @brief Rebuilds the cell tables for the current positions.
+	 */
+	void rebuildCells() {
+#pragma omp parallel
+		rebuildCellsInTeam();
+	}
+	void rebuildCellsInTeam();
+
+	/********************************************//**
+	 *--------------------AUTOTUNE-------------------
+	 ***********************************************/
+
+	//Team size and blocks per thread picked by autotune. Zero if it did not run.
+	int tunedThreads;
+	int tunedBlocks;
+
+	/**
+	 * @brief Times cell rebuilds and force passes under candidate team sizes, blocks per thread
+	 * and cell scales, then keeps the fastest. The particles are not moved.
+	 * @param cfg The config file reader.
+	 */
+	void autotune(config* cfg);
+	/**
+	 * @brief The mean seconds of a cell rebuild and force pass.
+	 * @param passes The number of timed passes.
+	 */
+	double timeForcePass(int passes);
+	/**
+	 * @brief Changes the cell grid and rebuilds the cell tables. The box does not change.
+	 * @param scale Cells along each side. Must divide the box size.
+	 */
+	void setCellScale(int scale);
+
+	/********************************************//**
+	 *-------------------TEAM STEP-------------------
+	 ***********************************************/
+
+	//Functions named InTeam are called by every thread of an open parallel region and share
+	//their loops with orphaned worksharing. Each has a wrapper without the suffix that opens the region.
+
+	/**
+	 * @brief One fixed time step, from the force pass to the new interaction lists.
+	 * Forces, integration, cells and interactions run in one team, separated only by the barriers they need.
+	 */
+	void stepInTeam();
+
+	/**
+	 * @brief Gets the species of a particle from its place in the table.
+	 * @param i The particle index.
+	 */
+	int speciesOf(int i);
 
 
 	/********************************************//**
@@ -95,6 +290,10 @@ private:
 
 	void verifyPath();
 	void estimateCompletion(PSim::timer* tmr);
+	/**
+	 * @brief Measures the containers the system grows on its own for the memoryTracker.
+	 */
+	void trackMemory();
 	void writeToStream(string path, double value);
 	void setSystemConstants(config* cfg,
 			PSim::IIntegrator* sysInt, PSim::defaultForceManager* sysFcs);
@@ -161,11 +360,25 @@ public:
 	 * @param endTime When to stop running the simulation.
 	 */
 	void run(double endTime);
+	/**
+	 * @brief Allocates the cell tables and bins every particle.
+	 */
+	void initCells();
 	void hashParticles();
+	void hashParticlesInTeam();
+	/**
+	 * @brief Sorts the mobile part of the hash table by run, then by particle.
+	 * The order does not depend on the number of threads.
+	 */
 	void sortParticles();
-	void clearCells() { std::fill(cellStartEnd.begin(), cellStartEnd.end(), tuple<int,int>(0xffffffff, 0xffffffff)); };
+	void sortParticlesInTeam();
+	void clearCells() { std::fill(cellStartEnd.begin(), cellStartEnd.begin() + (state.cellScale * state.cellScale * state.cellScale * state.nSpecies), tuple<int,int>(emptyCell, emptyCell)); };
 	void reorderParticles();
 	void updateInteractions();
+	/**
+	 * @brief Shares the particles across the team. Ends without a barrier.
+	 */
+	void updateInteractionsInTeam();
 
 	/********************************************//**
 	 *------------------SYSTEM OUTPUT-----------------
@@ -216,7 +429,7 @@ public:
 	 * @brief Runs the tests and analysis provided in the input string.
 	 * @param tests
 	 */
-	void analysisManager(std::queue<std::string>* tests) { analysis->postAnalysis(tests, particles, &state); }
+	void analysisManager(std::queue<std::string>* tests) { analysis->postAnalysis(tests, particlesById.data(), &state); }
 	/**
 	 *
 	 * @brief Sets a new time step. Use with caution.
@@ -44,6 +44,23 @@ enum Colour {
 	Black, Red, Green, Brown, Blue, Magenta, Cyan, Grey, Normal
 };
 
+/**
+ * @brief Square and multiply decomposition of base^N resolved by the compiler.
+ */
+template<int N>
+struct fixedPow {
+	static inline double of(double base) {
+		return fixedPow<N / 2>::of(base * base) * ((N & 1) ? base : 1.0);
+	}
+};
+
+template<>
+struct fixedPow<0> {
+	static inline double of(double base) {
+		return 1.0;
+	}
+};
+
 /**
  * @class util
  * @author Sawyer Hopkins
@@ -74,6 +91,28 @@ public:
 	 */
 	static double safeMod0(double val0, double val, double base);
 
+	/**
+	 * @brief Branch free safeMod. Gives the same result and vectorizes.
+	 * @param val The value of the perform the division on.
+	 * @param base The base of the modular divison.
+	 */
+	static inline double wrapPBC(double val, double base) {
+		return val + (base * (double(val < 0) - double(val >= base)));
+	}
+
+	/**
+	 * @brief Branch free safeMod0. Gives the same result and vectorizes.
+	 * @param val0 Old position.
+	 * @param val New position.
+	 * @param base The size of the system.
+	 * @return The new old position.
+	 */
+	static inline double wrapPBC0(double val0, double val, double base) {
+		double dx = val - val0;
+		double shift = double(fabs(dx) > (base / 2)) * ((dx < 0) ? -1.0 : 1.0);
+		return val0 + (base * shift);
+	}
+
 	/**
 	 * @brief Method for getting distance between two points.
 	 * @param X,Y,Z The position of the first particle
@@ -139,6 +178,14 @@ public:
 	 * @return
 	 */
 	static double powBinaryDecomp(double base, int exp);
+	/**
+	 * @brief Integer power with the exponent fixed at compile time.
+	 * @param base The base value
+	 * @return base^N as an unrolled chain of multiplies.
+	 */
+	template<int N> static double powFixed(double base) {
+		return fixedPow<N>::of(base);
+	}
 
 	/**
 	 * A keyed sorting algorithm. First tuple value is defined as the key.
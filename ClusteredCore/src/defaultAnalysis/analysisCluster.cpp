@@ -24,30 +24,32 @@
 
 namespace PSim {
 std::vector<std::vector<particle*>> analysisManager::findClusters(particle** particles, int nParticles) {
-	//A map of all the particles in the system by name.
-	std::map<int, particle*> selectionPool;
-
-	//Add all the particles to the map.
+	//All the particles in the system by name, and whether each is still unclaimed.
+	scratch.reset();
+	particle** byName = scratch.allocate<particle*>(nParticles);
+	char* selectionPool = scratch.allocate<char>(nParticles);
 	for (int i = 0; i < nParticles; i++) {
-		selectionPool[particles[i]->getName()] = particles[i];
+		byName[(int) particles[i]->getName()] = particles[i];
+		selectionPool[i] = 1;
 	}
 
 	//Create a vector of clusters.
 	int totalSize = 0;
 	std::vector<std::vector<particle*>> clusterPool;
+	//The cluster candidate and the searching pool. Cleared for each cluster, so they keep their memory.
+	std::vector<particle*> candidate;
+	std::vector<particle*> recursionPool;
+
+	//Start a cluster from each unclaimed particle, lowest name first.
+	for (int name = 0; name < nParticles; name++) {
+		if (!selectionPool[name]) {
+			continue;
+		}
+		candidate.clear();
+		recursionPool.clear();
 
-	//While we still have particles in pList look for clusters.
-	while (!selectionPool.empty()) {
-		//The cluster candidate.
-		std::vector<particle*> candidate;
-
-		//Get the base particle.
-		particle* p = selectionPool.begin()->second;
-
-		//Recreate a searching pool
-		std::vector<particle*> recursionPool;
 		//Add the base particle to the recursive search.
-		recursionPool.push_back(p);
+		recursionPool.push_back(byName[name]);
 
 		//Recurse.
 		while (!recursionPool.empty()) {
@@ -57,10 +59,10 @@ std::vector<std::vector<particle*>> analysisManager::findClusters(particle** par
 			recursionPool.pop_back();
 
 			//If the particle is still in the selection pool.
-			if (selectionPool.count(r->getName())) {
+			if (selectionPool[(int) r->getName()]) {
 
 				//Remove the particle from the selection pool.
-				selectionPool.erase(r->getName());
+				selectionPool[(int) r->getName()] = 0;
 				//Add the particle to the cluster candidate
 				candidate.push_back(r);
 
@@ -82,7 +84,7 @@ std::vector<std::vector<particle*>> analysisManager::findClusters(particle** par
 	return clusterPool;
 }
 
-int analysisManager::writeClusters(std::vector<std::vector<particle*>> clusterPool, double currentTime,
+int analysisManager::writeClusters(const std::vector<std::vector<particle*>>& clusterPool, double currentTime,
 		int xyz) {
 	int totalSize = 0;
 	int avgSize = 0;
@@ -127,13 +129,13 @@ int analysisManager::writeClusters(std::vector<std::vector<particle*>> clusterPo
 
 	}
 
-	chatterBox.consoleMessage("#Clusters: " + tos(clusterPool.size()));
+	say("#Clusters: " + tos(clusterPool.size()));
 
 	return avgSize;
 }
 
 void analysisManager::clusterSizeHistogram(
-		std::vector<std::vector<particle*>> clusterPool) {
+		const std::vector<std::vector<particle*>>& clusterPool) {
 	std::map<int, int> histo;
 
 	for (auto clustIT = clusterPool.begin(); clustIT != clusterPool.end();
@@ -156,7 +158,7 @@ void analysisManager::clusterSizeHistogram(
 }
 
 void analysisManager::clusterCoorHistogram(
-		std::vector<std::vector<particle*>> clusterPool) {
+		const std::vector<std::vector<particle*>>& clusterPool) {
 	std::map<int, int> histo;
 
 	// Iterate over each cluster
@@ -21,20 +21,23 @@
  SOFTWARE.*/
 
 #include "analysisManager.h"
+#include "numa.h"
 
 namespace PSim {
 
-analysisManager::analysisManager(string tName, systemState* state) {
+analysisManager::analysisManager(string tName, systemState* state, bool asyncOutput) {
 	trialName = tName;
 	int nParticles = state->nParticles;
-	xStart = new float [nParticles];
-	yStart = new float [nParticles];
-	zStart = new float [nParticles];
-	xPBC = new int[nParticles];
-	yPBC = new int[nParticles];
-	zPBC = new int[nParticles];
+	xStart = trackerPool.allocate<float>(nParticles);
+	yStart = trackerPool.allocate<float>(nParticles);
+	zStart = trackerPool.allocate<float>(nParticles);
+	xPBC = trackerPool.allocate<int>(nParticles);
+	yPBC = trackerPool.allocate<int>(nParticles);
+	zPBC = trackerPool.allocate<int>(nParticles);
 	counter = 0;
+	nextOutput = 0;
 	boxSize = state->boxSize;
+	nSpecies = state->nSpecies;
 
 	for (int i = 0; i < nParticles; i++)
 	{
@@ -45,6 +48,42 @@ analysisManager::analysisManager(string tName, systemState* state) {
 		yPBC[i] = 0;
 		zPBC[i] = 0;
 	}
+
+	async = asyncOutput;
+	nextFrame = 0;
+	written = false;
+	pending = NULL;
+	for (int b = 0; b < 2; b++) {
+		frames[b].store = NULL;
+		frames[b].byName = NULL;
+		frames[b].items = NULL;
+		if (!async) {
+			continue;
+		}
+		frames[b].store = new particleStore(nParticles, "analysis");
+		frames[b].byName = framePool.allocate<particle*>(nParticles);
+		frames[b].items = framePool.allocate<particle*>(nParticles);
+		for (int i = 0; i < nParticles; i++) {
+			frames[b].byName[i] = framePool.create<particle>(i, frames[b].store, i);
+		}
+		for (int a = 0; a < 3; a++) {
+			frames[b].pbc[a] = framePool.allocate<int>(nParticles);
+		}
+	}
+	frameSize = nParticles;
+}
+
+analysisManager::~analysisManager() {
+	flush();
+	for (int b = 0; b < 2; b++) {
+		if (frames[b].store == NULL) {
+			continue;
+		}
+		for (int i = 0; i < frameSize; i++) {
+			frames[b].byName[i]->~particle();
+		}
+		delete frames[b].store;
+	}
 }
 
 void analysisManager::writeInitialState(particle** particles, systemState* state) {
@@ -57,23 +96,126 @@ void analysisManager::writeInitialState(particle** particles, systemState* state
 }
 
 void analysisManager::writeRunTimeState(particle** particles, systemState* state) {
-	//Output a snapshot every second.
-	if ((counter % state->outputFreq) == 0) {
+	//Print the last snapshot as soon as it is written.
+	collect(false);
+
+	//Output a snapshot every second. Adaptive steps are counted by time, not by step.
+	bool snapshot = ((counter % state->outputFreq) == 0);
+	if (state->outputInterval > 0) {
+		//The system lands steps on the snapshot times, up to rounding.
+		snapshot = (state->currentTime >= nextOutput - (1e-9 * state->outputInterval));
+		nextOutput += (snapshot) ? state->outputInterval : 0;
+	}
+	//The crossing counts must see every step, so they stay on the main thread.
+	updateTracker(particles, state->nParticles);
+	if (snapshot) {
 		if (state->currentTime > 0) {
 			PSim::util::clearLines(-1);
 		}
-		writeSystemState(particles, state->nParticles, state->currentTime);
-	} else {
-		updateTracker(particles, state->nParticles);
+		std::string outName = std::to_string(int(std::round(state->currentTime)));
+		util::writeTerminal("Writing: " + outName + ".txt", Colour::Cyan);
+
+		if (!async) {
+			frame live;
+			live.store = NULL;
+			live.byName = NULL;
+			live.items = particles;
+			live.pbc[0] = xPBC;
+			live.pbc[1] = yPBC;
+			live.pbc[2] = zPBC;
+			live.currentTime = state->currentTime;
+			writeSystemState(&live, state->nParticles);
+		} else {
+			frame* f = &frames[nextFrame];
+			nextFrame = 1 - nextFrame;
+			capture(f, particles, state->nParticles, state->currentTime);
+			//Snapshots are written in order, so wait for the last one before handing over this one.
+			collect(true);
+			int nParticles = state->nParticles;
+			written = false;
+			writer = std::thread([this, f, nParticles]() {
+				//Keep off the cores of the force loop.
+				numa::unpin();
+				pending = &f->messages;
+				writeSystemState(f, nParticles);
+				pending = NULL;
+				written = true;
+			});
+		}
 	}
 	counter++;
 }
 
-void analysisManager::writeFinalState(particle** particles, systemState* state) {
-	writeSystem(particles, state->nParticles, trialName + "/finalState");
+void analysisManager::capture(frame* f, particle** particles, int nParticles, double currentTime) {
+	particleStore* s = f->store;
+	particle** byName = f->byName;
+	//Copies are kept by name, since reordering moves particles between slots.
+#pragma omp parallel for
+	for (int i = 0; i < nParticles; i++) {
+		const particle* p = particles[i];
+		int n = (int) p->getName();
+		s->x[n] = p->getX();
+		s->y[n] = p->getY();
+		s->z[n] = p->getZ();
+		s->x0[n] = p->getX0();
+		s->y0[n] = p->getY0();
+		s->z0[n] = p->getZ0();
+		s->vx[n] = p->getVX();
+		s->vy[n] = p->getVY();
+		s->vz[n] = p->getVZ();
+		s->force[3*n] = p->getFX();
+		s->force[3*n+1] = p->getFY();
+		s->force[3*n+2] = p->getFZ();
+		s->force0[3*n] = p->getFX0();
+		s->force0[3*n+1] = p->getFY0();
+		s->force0[3*n+2] = p->getFZ0();
+		s->radius[n] = p->getRadius();
+		s->mass[n] = p->getMass();
+
+		particle* copy = byName[n];
+		copy->setSpecies(p->getSpecies());
+		copy->setFrozen(p->isFrozen());
+		copy->clearInteractions();
+		const std::vector<particle*>& contacts = p->getInteractions();
+		for (unsigned int c = 0; c < contacts.size(); c++) {
+			copy->addInteraction(byName[(int) contacts[c]->getName()]);
+		}
+		f->items[i] = copy;
+	}
+	std::copy(xPBC, xPBC + nParticles, (int*) f->pbc[0]);
+	std::copy(yPBC, yPBC + nParticles, (int*) f->pbc[1]);
+	std::copy(zPBC, zPBC + nParticles, (int*) f->pbc[2]);
+	f->currentTime = currentTime;
+	f->messages.clear();
 }
 
+void analysisManager::collect(bool block) {
+	if (!writer.joinable() || (!block && !written)) {
+		return;
+	}
+	writer.join();
+	frame* f = &frames[1 - nextFrame];
+	for (unsigned int m = 0; m < f->messages.size(); m++) {
+		chatterBox.consoleMessage(f->messages[m]);
+	}
+	f->messages.clear();
 }
 
+void analysisManager::flush() {
+	collect(true);
+}
 
+void analysisManager::say(const std::string& message) {
+	if (pending != NULL) {
+		pending->push_back(message);
+	} else {
+		chatterBox.consoleMessage(message);
+	}
+}
 
+void analysisManager::writeFinalState(particle** particles, systemState* state) {
+	flush();
+	writeSystem(particles, state->nParticles, trialName + "/finalState");
+}
+
+}
@@ -54,6 +54,11 @@ void analysisManager::writeSystem(particle** particles, int nParticles, std::str
 	//Create a stream to the desired file.
 	std::ofstream myFile;
 	myFile.open(name + ".txt");
+	//Frozen particles need the species and frozen columns.
+	bool anyFrozen = false;
+	for (int i = 0; i < nParticles; i++) {
+		anyFrozen = anyFrozen || particles[i]->isFrozen();
+	}
 	//Write each point in the system as a line of csv formatted as: X,Y,Z
 	for (int i = 0; i < nParticles; i++) {
 		myFile << particles[i]->getX() << " " << particles[i]->getY() << " "
@@ -65,6 +70,12 @@ void analysisManager::writeSystem(particle** particles, int nParticles, std::str
 		myFile << particles[i]->getFX0() << " " << particles[i]->getFY0() << " "
 				<< particles[i]->getFZ0() << " ";
 		myFile << particles[i]->getMass() << " " << particles[i]->getRadius();
+		if (nSpecies > 1 || anyFrozen) {
+			myFile << " " << particles[i]->getSpecies();
+		}
+		if (anyFrozen) {
+			myFile << " " << particles[i]->isFrozen();
+		}
 		if (i < (nParticles - 1)) {
 			myFile << "\n";
 		}
@@ -96,14 +107,13 @@ void analysisManager::writeToStream(double currentTime, string path, double valu
 	myFile.close();
 }
 
-void analysisManager::writeSystemState(particle** particles, int nParticles, double currentTime) {
-	//Update the console.
+void analysisManager::writeSystemState(frame* f, int nParticles) {
+	particle** particles = f->items;
+	double currentTime = f->currentTime;
 	bool outXYZ = true;
 
 	std::string outName = std::to_string(int(std::round(currentTime)));
 
-	util::writeTerminal("Writing: " + outName + ".txt", Colour::Cyan);
-
 	//Write the recovery image.
 	std::string dirName = trialName + "/snapshots/time-" + outName;
 	mkdir(dirName.c_str(), 0777);
@@ -125,14 +135,14 @@ void analysisManager::writeSystemState(particle** particles, int nParticles, dou
 	double nClust = writeClusters(particles, nParticles, currentTime, outXYZ);
 	double avgCoor = double(totalCoor) / double(nParticles);
 	double meanR2 = meanDisplacement(particles, nParticles);
-	double trackedMeanR2 = trackedDisplacement(particles, nParticles);
+	double trackedMeanR2 = trackedDisplacement(particles, nParticles, f->pbc);
 
 	//Output the current system statistics.
-	chatterBox.consoleMessage("<Coor>: " + tos(avgCoor) + " - Total Coor: " + tos(totalCoor));
-	chatterBox.consoleMessage("<EAP>: " + tos(pot));
-	chatterBox.consoleMessage("<N>/Nc: " + tos(nClust));
-	chatterBox.consoleMessage("<R^2>: " + tos(meanR2));
-	chatterBox.consoleMessage("Temperature: " + tos(getTemperature(particles, nParticles)));
+	say("<Coor>: " + tos(avgCoor) + " - Total Coor: " + tos(totalCoor));
+	say("<EAP>: " + tos(pot));
+	say("<N>/Nc: " + tos(nClust));
+	say("<R^2>: " + tos(meanR2));
+	say("Temperature: " + tos(getTemperature(particles, nParticles)));
 
 	writeToStream(currentTime, trialName + "/clustGraph.txt", nClust);
 	writeToStream(currentTime, trialName + "/coorGraph.txt", avgCoor);
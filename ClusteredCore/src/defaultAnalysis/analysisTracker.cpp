@@ -63,21 +63,18 @@ void analysisManager::updateTracker(particle** particles, int nParticles) {
 	}
 }
 
-double analysisManager::trackedDisplacement(particle** particles, int nParticles) {
+double analysisManager::trackedDisplacement(particle** particles, int nParticles, const int* const* pbc) {
 	float dr = 0.0;
 	for (int i = 0; i < nParticles; i++)
 	{
-		//Check boundary condition crossings..
-		updateParticlePBC(i, particles);
-
 		float dx = particles[i]->getX() - xStart[i];
-		dx += boxSize * xPBC[i];
+		dx += boxSize * pbc[0][i];
 		dr += (dx*dx);
 		float dy = particles[i]->getY() - yStart[i];
-		dy += boxSize * yPBC[i];
+		dy += boxSize * pbc[1][i];
 		dr += (dy*dy);
 		float dz = particles[i]->getZ() - zStart[i];
-		dz += boxSize * zPBC[i];
+		dz += boxSize * pbc[2][i];
 		dr += (dz*dz);
 	}
 	dr /= nParticles;
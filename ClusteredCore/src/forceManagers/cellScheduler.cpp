@@ -0,0 +1,181 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "cellScheduler.h"
+#include "defs.h"
+#include <algorithm>
+
+namespace PSim {
+
+cellScheduler::cellScheduler() {
+	blocksPerThread = 8;
+	wall = 0;
+	passes = 0;
+}
+
+void cellScheduler::plan(std::vector<std::tuple<int,int>>* cellStartEnd, systemState* state, int threads) {
+	using std::get;
+	int scale = state->cellScale;
+	int numCells = scale * scale * scale;
+	int nSpecies = state->nSpecies;
+	int nRuns = state->runsPerCell();
+
+	occupancy.assign(numCells, 0);
+	weight.assign(numCells, 0.0);
+	firstParticle.assign(numCells + 1, 0);
+
+	//Mobile particles need a force. Every particle is a partner.
+	std::vector<double> partners(numCells, 0.0);
+	for (int hash = 0; hash < numCells; hash++) {
+		for (int k = 0; k < nRuns; k++) {
+			std::tuple<int,int> run = (*cellStartEnd)[state->runIndex(hash, k)];
+			if (get<0>(run) == emptyCell) {
+				continue;
+			}
+			int n = get<1>(run) - get<0>(run);
+			partners[hash] += n;
+			if (k < nSpecies) {
+				occupancy[hash] += n;
+			}
+		}
+		//Mobile particles are sorted by cell, so a prefix sum gives their first index.
+		firstParticle[hash + 1] = firstParticle[hash] + occupancy[hash];
+	}
+
+	//Sum the 27 neighbors one axis at a time.
+	int stride[3] = {1, scale, scale * scale};
+	std::vector<double> line(numCells);
+	for (int axis = 0; axis < 3; axis++) {
+		int s = stride[axis];
+		for (int hash = 0; hash < numCells; hash++) {
+			int c = (hash / s) % scale;
+			int down = (c == 0) ? hash + (scale - 1) * s : hash - s;
+			int up = (c == scale - 1) ? hash - (scale - 1) * s : hash + s;
+			line[hash] = partners[hash] + ((scale > 1) ? partners[down] : 0) + ((scale > 2) ? partners[up] : 0);
+		}
+		partners.swap(line);
+	}
+
+	//Empty cells still cost a visit.
+	double total = 0;
+	for (int hash = 0; hash < numCells; hash++) {
+		weight[hash] = occupancy[hash] * partners[hash] + 1.0;
+		total += weight[hash];
+	}
+
+	//Cut whole cells into blocks of near equal weight.
+	int target = threads * blocksPerThread;
+	double share = total / target;
+	blocks.clear();
+	double sum = 0;
+	int first = 0;
+	for (int hash = 0; hash < numCells; hash++) {
+		sum += weight[hash];
+		if (sum >= share * (blocks.size() + 1) || hash == numCells - 1) {
+			block b = {first, hash + 1, firstParticle[first], firstParticle[hash + 1]};
+			blocks.push_back(b);
+			first = hash + 1;
+		}
+	}
+
+	//Deal contiguous runs of blocks to each thread.
+	if ((int) queues.size() != threads) {
+		std::vector<std::atomic<uint64_t>> fresh(threads);
+		queues.swap(fresh);
+		busy.assign(threads, 0.0);
+	}
+	int nBlocks = blocks.size();
+	for (int t = 0; t < threads; t++) {
+		uint32_t front = ((long) nBlocks * t) / threads;
+		uint32_t back = ((long) nBlocks * (t + 1)) / threads;
+		queues[t].store(pack(front, back));
+	}
+}
+
+int cellScheduler::popFront(int t) {
+	if (t >= (int) queues.size()) {
+		return -1;
+	}
+	uint64_t q = queues[t].load();
+	while (true) {
+		uint32_t front = q & 0xffffffff;
+		uint32_t back = q >> 32;
+		if (front >= back) {
+			return -1;
+		}
+		if (queues[t].compare_exchange_weak(q, pack(front + 1, back))) {
+			return front;
+		}
+	}
+}
+
+int cellScheduler::popBack(int t) {
+	int threads = queues.size();
+	//Start with the next thread so thieves spread over the victims.
+	for (int i = 1; i <= threads; i++) {
+		int v = (t + i) % threads;
+		uint64_t q = queues[v].load();
+		while (true) {
+			uint32_t front = q & 0xffffffff;
+			uint32_t back = q >> 32;
+			if (front >= back) {
+				break;
+			}
+			if (queues[v].compare_exchange_weak(q, pack(front, back - 1))) {
+				return back - 1;
+			}
+		}
+	}
+	return -1;
+}
+
+void cellScheduler::report() {
+	if (passes == 0 || wall <= 0) {
+		return;
+	}
+	std::string msg = "Force threads busy (%):";
+	double most = 0;
+	double mean = 0;
+	for (unsigned int t = 0; t < busy.size(); t++) {
+		double f = busy[t] / wall;
+		most = (f > most) ? f : most;
+		mean += f / busy.size();
+		msg += " " + tos((int) (100 * f + 0.5));
+		busy[t] = 0;
+	}
+	chatterBox.consoleMessage(msg);
+	//One for a perfect split. The pass takes as long as its busiest thread.
+	if (mean > 0) {
+		chatterBox.consoleMessage("Force imbalance (max/mean): " + tos(most / mean));
+	}
+	wall = 0;
+	passes = 0;
+}
+
+void cellScheduler::clear() {
+	std::fill(busy.begin(), busy.end(), 0.0);
+	wall = 0;
+	passes = 0;
+}
+
+}
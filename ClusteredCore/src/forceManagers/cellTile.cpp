@@ -0,0 +1,148 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+#include "cellTile.h"
+#include "numa.h"
+
+namespace PSim {
+
+cellTile::cellTile() {
+	capacity = 0;
+	tracker = memoryTracker::owner();
+	size = 0;
+	x = NULL;
+	y = NULL;
+	z = NULL;
+	r = NULL;
+	index = NULL;
+	reserve(64);
+}
+
+cellTile::~cellTile() {
+	numa::release(x);
+	numa::release(y);
+	numa::release(z);
+	numa::release(r);
+	numa::release(index);
+}
+
+void cellTile::reserve(int n) {
+	if (n <= capacity) {
+		return;
+	}
+	//Grow geometrically so a tile settles after a few cells.
+	int newCapacity = (2 * capacity > n) ? 2 * capacity : n;
+
+	double* buffers[4] = {NULL, NULL, NULL, NULL};
+	double* old[4] = {x, y, z, r};
+	for (int b = 0; b < 4; b++) {
+		//Cache line aligned for the vector units.
+		buffers[b] = (double*) numa::reserve(newCapacity * sizeof(double), "forceTiles", tracker);
+		for (int i = 0; i < size; i++) {
+			buffers[b][i] = old[b][i];
+		}
+		numa::release(old[b]);
+	}
+	x = buffers[0];
+	y = buffers[1];
+	z = buffers[2];
+	r = buffers[3];
+
+	int* newIndex = (int*) numa::reserve(newCapacity * sizeof(int), "forceTiles", tracker);
+	for (int i = 0; i < size; i++) {
+		newIndex[i] = index[i];
+	}
+	numa::release(index);
+	index = newIndex;
+
+	capacity = newCapacity;
+}
+
+bool cellTile::load(int hash, double* sortedParticles, std::vector<std::tuple<int,int>>* cellStartEnd, systemState* state) {
+	using std::get;
+	int nSpecies = state->nSpecies;
+	int nRuns = state->runsPerCell();
+	int scale = state->cellScale;
+	int cellScaleSq = scale*scale;
+
+	//Only mobile particles need a force.
+	home.clear();
+	for (int s = 0; s < nSpecies; s++) {
+		int run = (hash * nSpecies) + s;
+		int start = get<0>((*cellStartEnd)[run]);
+		if (start != emptyCell) {
+			tileRun h = {start, get<1>((*cellStartEnd)[run]), s, hash, 13};
+			home.push_back(h);
+		}
+	}
+	if (home.empty()) {
+		return false;
+	}
+
+	type3<int> cell = type3<int>(hash % scale, (hash / scale) % scale, hash / cellScaleSq);
+	type3<int> cRef = type3<int>();
+
+	runs.clear();
+	size = 0;
+	int slot = 0;
+	//Same neighbor order as the per particle traversal.
+	for (int dx=-1; dx<=1; dx++) {
+		for (int dy=-1; dy<=1; dy++) {
+			for (int dz=-1; dz<=1; dz++) {
+				cRef.x = (cell.x + dx) % scale;
+				cRef.y = (cell.y + dy) % scale;
+				cRef.z = (cell.z + dz) % scale;
+
+				cRef.x = (cRef.x < 0) ? cRef.x + scale : cRef.x;
+				cRef.y = (cRef.y < 0) ? cRef.y + scale : cRef.y;
+				cRef.z = (cRef.z < 0) ? cRef.z + scale : cRef.z;
+
+				int nHash = cRef.x + (scale * cRef.y) + (cellScaleSq * cRef.z);
+
+				for (int k = 0; k < nRuns; k++) {
+					int run = state->runIndex(nHash, k);
+					int start = get<0>((*cellStartEnd)[run]);
+					if (start == emptyCell) {
+						continue;
+					}
+					int end = get<1>((*cellStartEnd)[run]);
+					reserve(size + (end - start));
+
+					tileRun t = {size, size + (end - start), k % nSpecies, nHash, slot};
+					for (int i = start; i < end; i++) {
+						x[size] = sortedParticles[4*i];
+						y[size] = sortedParticles[4*i+1];
+						z[size] = sortedParticles[4*i+2];
+						r[size] = sortedParticles[4*i+3];
+						index[size] = i;
+						size++;
+					}
+					runs.push_back(t);
+				}
+				slot++;
+			}
+		}
+	}
+	return true;
+}
+
+}
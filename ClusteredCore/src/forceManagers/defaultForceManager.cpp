@@ -35,10 +35,14 @@ defaultForceManager::defaultForceManager() {
 }
 
 defaultForceManager::~defaultForceManager() {
+	for (unsigned int t = 0; t < tiles.size(); t++) {
+		delete tiles[t];
+	}
 	//Free memory from the Force associated with the IForce Pointer.
+	for (unsigned int f = 0; f < flist.size(); f++) {
+		delete flist[f];
+	}
 	flist.clear();
-	//Free memory of the IForce Pointers.
-	delete &flist;
 }
 
 /********************************************//**
@@ -53,26 +57,84 @@ void defaultForceManager::addForce(IForce* f) {
 }
 
 void defaultForceManager::getAcceleration(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd,systemState* state) {
-	IForce* currentForce = flist[0];
+	prepareAcceleration(sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
 #pragma omp parallel
-	{
-#pragma omp for
-		for (int index = 0; index < state->nParticles; index++) {
-			//Iterates through all forces.
-			currentForce->getAcceleration(index, sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
-		}
+	getAccelerationInTeam(sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
+	failure.rethrow();
+}
+
+void defaultForceManager::prepareAcceleration(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd,systemState* state) {
+	IForce* currentForce = flist[0];
+	//Global calculations needed before the particle loop.
+	currentForce->preRoutine(sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
+	int threads = omp_get_max_threads();
+	//Cell occupancy is uneven once clusters form, so cells are dealt by pair work.
+	scheduler.plan(cellStartEnd, state, threads);
+	//Each thread stages its neighbors in its own tile.
+	while ((int) tiles.size() < threads) {
+		tiles.push_back(new cellTile());
 	}
 }
 
+void defaultForceManager::getAccelerationInTeam(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd,systemState* state) {
+	IForce* currentForce = flist[0];
+	double start = omp_get_wtime();
+	if (currentForce->isTiled()) {
+		//Walk home cells.
+		cellTile* tile = tiles[omp_get_thread_num()];
+		scheduler.run([&](const cellScheduler::block& b) {
+			//Once a force has failed the rest of the pass is skipped.
+			if (failure.raised()) {
+				return;
+			}
+			try {
+				for (int hash = b.firstCell; hash < b.endCell; hash++) {
+					currentForce->getTileAcceleration(hash, tile, sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
+				}
+			} catch (...) {
+				failure.record();
+			}
+		});
+	} else {
+		//Frozen particles are sorted last and never need a force, so the blocks cover the mobile ones.
+		scheduler.run([&](const cellScheduler::block& b) {
+			if (failure.raised()) {
+				return;
+			}
+			try {
+				for (int index = b.firstParticle; index < b.endParticle; index++) {
+					//Iterates through all forces.
+					currentForce->getAcceleration(index, sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
+				}
+			} catch (...) {
+				failure.record();
+			}
+		});
+	}
+#pragma omp barrier
+#pragma omp master
+	scheduler.addWall(omp_get_wtime() - start);
+}
+
 #ifdef WITHPOST
 void defaultForceManager::getPostRoutine(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd,systemState* state) {
-	IForce* currentForce = flist[0];
 #pragma omp parallel
-	{
+	getPostRoutineInTeam(sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
+	failure.rethrow();
+}
+
+void defaultForceManager::getPostRoutineInTeam(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd,systemState* state) {
+	IForce* currentForce = flist[0];
 #pragma omp for
-		for (int index = 0; index < state->nParticles; index++) {
+	for (int index = 0; index < state->nParticles; index++) {
+		if (failure.raised()) {
+			continue;
+		}
+		try {
 			//Iterates through all forces.
 			currentForce->postRoutine(index, sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
+		} catch (...) {
+			failure.record();
 		}
 	}
 }
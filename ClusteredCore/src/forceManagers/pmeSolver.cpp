@@ -0,0 +1,320 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+#include "pmeSolver.h"
+#include "defs.h"
+#include "memoryTracker.h"
+#include <omp.h>
+
+namespace PSim {
+
+pmeSolver::pmeSolver(int gridSize, int splineOrder, double ewaldAlpha, double energyScale) {
+	alpha = ewaldAlpha;
+	prefactor = energyScale;
+	order = std::max(2, std::min(splineOrder, maxOrder));
+	boxSize = 0;
+	nParticles = 0;
+	requestedGrid = gridSize;
+	recipForce = NULL;
+	splineTheta = NULL;
+	splineDTheta = NULL;
+	splineBase = NULL;
+	threadGrid = NULL;
+	gridThreads = 0;
+	transform = NULL;
+	grid = NULL;
+	influence = NULL;
+}
+
+pmeSolver::~pmeSolver() {
+	memoryTracker::remove(grid);
+	memoryTracker::remove(influence);
+	memoryTracker::remove(recipForce);
+	memoryTracker::remove(splineTheta);
+	memoryTracker::remove(splineDTheta);
+	memoryTracker::remove(splineBase);
+	memoryTracker::remove(threadGrid);
+	delete transform;
+	delete[] grid;
+	delete[] influence;
+	delete[] recipForce;
+	delete[] splineTheta;
+	delete[] splineDTheta;
+	delete[] splineBase;
+	delete[] threadGrid;
+}
+
+double pmeSolver::bSpline(int n, double x) {
+	//Closed form of the cardinal B-spline.
+	//M_n(x) = 1/(n-1)! sum_k (-1)^k C(n,k) (x-k)_+^(n-1)
+	if (x <= 0.0 || x >= n) {
+		return 0.0;
+	}
+	double sum = 0.0;
+	double binom = 1.0;
+	double fact = 1.0;
+	for (int k = 1; k < n; k++) {
+		fact *= k;
+	}
+	for (int k = 0; k <= n; k++) {
+		double t = x - k;
+		if (t > 0.0) {
+			double term = 1.0;
+			for (int p = 0; p < n - 1; p++) {
+				term *= t;
+			}
+			sum += (k & 1) ? -binom * term : binom * term;
+		}
+		binom = binom * (n - k) / (k + 1);
+	}
+	return sum / fact;
+}
+
+void pmeSolver::splineWeights(double w, double* theta, double* dTheta) {
+	//Grid point floor(u)-j sees the spline at w+j.
+	//M_k(x) = (x M_k-1(x) + (k-x) M_k-1(x-1)) / (k-1), from M_1(w) = 1.
+	theta[0] = 1.0;
+	for (int k = 2; k <= order; k++) {
+		if (k == order) {
+			//M_n'(x) = M_n-1(x) - M_n-1(x-1)
+			dTheta[0] = theta[0];
+			for (int j = 1; j < order - 1; j++) {
+				dTheta[j] = theta[j] - theta[j - 1];
+			}
+			dTheta[order - 1] = -theta[order - 2];
+		}
+		//Work down so the lower order weight at j-1 is still in place.
+		double div = 1.0 / (k - 1);
+		theta[k - 1] = (1.0 - w) * theta[k - 2] * div;
+		for (int j = k - 2; j > 0; j--) {
+			theta[j] = ((w + j) * theta[j] + (k - w - j) * theta[j - 1]) * div;
+		}
+		theta[0] = w * theta[0] * div;
+	}
+}
+
+void pmeSolver::buildGrid(int L) {
+	memoryTracker::remove(grid);
+	memoryTracker::remove(influence);
+	memoryTracker::remove(threadGrid);
+	delete transform;
+	delete[] grid;
+	delete[] influence;
+	delete[] threadGrid;
+	threadGrid = NULL;
+	gridThreads = 0;
+
+	//Mesh spacing of 0.8 / alpha keeps the relative force error near 1e-3 at order 4.
+	int points = (requestedGrid > 0) ? requestedGrid : int(ceil(alpha * L / 0.8));
+	transform = new fft3d(points);
+	int n = transform->getSize();
+	grid = new std::complex<double>[n * n * n];
+	influence = new double[n * n * n];
+	memoryTracker::add(grid, n * n * n * sizeof(std::complex<double>), "pme");
+	memoryTracker::add(influence, n * n * n * sizeof(double), "pme");
+
+	chatterBox.consoleMessage("PME grid: " + tos(n) + "^3 with spline order " + tos(order), 3);
+}
+
+void pmeSolver::buildInfluence(int L) {
+	int n = transform->getSize();
+	double pi = 4.0 * atan(1.0);
+	double volume = double(L) * L * L;
+
+	//Squared moduli of the euler exponential splines.
+	std::vector<double> bMod(n, 0.0);
+	for (int m = 0; m < n; m++) {
+		std::complex<double> den = 0.0;
+		for (int k = 0; k <= order - 2; k++) {
+			den += bSpline(order, k + 1.0) * std::polar(1.0, 2.0 * pi * m * k / n);
+		}
+		double den2 = std::norm(den);
+		bMod[m] = (den2 > 1e-10) ? 1.0 / den2 : 0.0;
+	}
+	//Odd orders vanish at the nyquist point. Interpolate through it.
+	for (int m = 0; m < n; m++) {
+		if (bMod[m] == 0.0) {
+			bMod[m] = 0.5 * (bMod[(m + n - 1) % n] + bMod[(m + 1) % n]);
+		}
+	}
+
+	double fac = pi * pi / (alpha * alpha);
+#pragma omp parallel for
+	for (int z = 0; z < n; z++) {
+		int mz = (z <= n / 2) ? z : z - n;
+		for (int y = 0; y < n; y++) {
+			int my = (y <= n / 2) ? y : y - n;
+			for (int x = 0; x < n; x++) {
+				int mx = (x <= n / 2) ? x : x - n;
+				int idx = x + n * (y + n * z);
+				double m2 = double(mx * mx + my * my + mz * mz) / (double(L) * L);
+				if (m2 == 0.0) {
+					//Neutralizing background.
+					influence[idx] = 0.0;
+				} else {
+					influence[idx] = prefactor * bMod[x] * bMod[y] * bMod[z] * exp(-fac * m2) / (pi * volume * m2);
+				}
+			}
+		}
+	}
+	boxSize = L;
+}
+
+void pmeSolver::computeForces(double* sortedParticles, double charge, systemState* state) {
+	int nPart = state->nParticles;
+	int L = state->boxSize;
+
+	if (L != boxSize) {
+		buildGrid(L);
+		buildInfluence(L);
+	}
+	int n = transform->getSize();
+	double scale = double(n) / double(L);
+
+	if (nPart != nParticles) {
+		memoryTracker::remove(recipForce);
+		memoryTracker::remove(splineTheta);
+		memoryTracker::remove(splineDTheta);
+		memoryTracker::remove(splineBase);
+		delete[] recipForce;
+		delete[] splineTheta;
+		delete[] splineDTheta;
+		delete[] splineBase;
+		recipForce = new double[3 * nPart];
+		splineTheta = new double[3 * order * nPart];
+		splineDTheta = new double[3 * order * nPart];
+		splineBase = new int[3 * nPart];
+		memoryTracker::add(recipForce, 3 * nPart * sizeof(double), "pme");
+		memoryTracker::add(splineTheta, 3 * order * nPart * sizeof(double), "pme");
+		memoryTracker::add(splineDTheta, 3 * order * nPart * sizeof(double), "pme");
+		memoryTracker::add(splineBase, 3 * nPart * sizeof(int), "pme");
+		nParticles = nPart;
+	}
+
+	//Each thread spreads onto its own mesh, so no mesh point is shared.
+	int gridPoints = n * n * n;
+	int threads = omp_get_max_threads();
+	if (threads != gridThreads) {
+		memoryTracker::remove(threadGrid);
+		delete[] threadGrid;
+		threadGrid = new double[(long) threads * gridPoints];
+		memoryTracker::add(threadGrid, (long) threads * gridPoints * sizeof(double), "pme");
+		gridThreads = threads;
+	}
+
+	int span = 3 * order;
+#pragma omp parallel
+	{
+		int team = omp_get_num_threads();
+		double* mesh = &threadGrid[(long) omp_get_thread_num() * gridPoints];
+		for (int k = 0; k < gridPoints; k++) {
+			mesh[k] = 0.0;
+		}
+
+		//Spread the charges onto the mesh.
+		//The weights are kept for the interpolation back to the particles.
+#pragma omp for
+		for (int i = 0; i < nPart; i++) {
+			double* theta = &splineTheta[span * i];
+			double* dTheta = &splineDTheta[span * i];
+			int* base = &splineBase[3 * i];
+			for (int d = 0; d < 3; d++) {
+				double u = sortedParticles[4 * i + d] * scale;
+				double fl = floor(u);
+				base[d] = int(fl);
+				splineWeights(u - fl, &theta[d * order], &dTheta[d * order]);
+			}
+			int gx[maxOrder];
+			for (int jx = 0; jx < order; jx++) {
+				gx[jx] = ((base[0] - jx) % n + n) % n;
+			}
+			for (int jz = 0; jz < order; jz++) {
+				int gz = ((base[2] - jz) % n + n) % n;
+				double wz = charge * theta[2 * order + jz];
+				for (int jy = 0; jy < order; jy++) {
+					int gy = ((base[1] - jy) % n + n) % n;
+					double wyz = wz * theta[order + jy];
+					double* row = &mesh[n * (gy + n * gz)];
+					for (int jx = 0; jx < order; jx++) {
+						row[gx[jx]] += wyz * theta[jx];
+					}
+				}
+			}
+		}
+
+		//Sum the thread meshes into the grid.
+#pragma omp for
+		for (int k = 0; k < gridPoints; k++) {
+			double sum = 0.0;
+			for (int t = 0; t < team; t++) {
+				sum += threadGrid[(long) t * gridPoints + k];
+			}
+			grid[k] = sum;
+		}
+	}
+
+	//Convolve with the influence function in reciprocal space.
+	transform->forward(grid);
+#pragma omp parallel for
+	for (int k = 0; k < gridPoints; k++) {
+		grid[k] *= influence[k];
+	}
+	transform->backward(grid);
+
+	//Interpolate the force back to the particles.
+#pragma omp parallel for
+	for (int i = 0; i < nPart; i++) {
+		const double* theta = &splineTheta[span * i];
+		const double* dTheta = &splineDTheta[span * i];
+		const int* base = &splineBase[3 * i];
+		const double* thetaY = &theta[order];
+		const double* thetaZ = &theta[2 * order];
+		const double* dThetaY = &dTheta[order];
+		const double* dThetaZ = &dTheta[2 * order];
+		int gx[maxOrder];
+		for (int jx = 0; jx < order; jx++) {
+			gx[jx] = ((base[0] - jx) % n + n) % n;
+		}
+		double fx = 0.0;
+		double fy = 0.0;
+		double fz = 0.0;
+		for (int jz = 0; jz < order; jz++) {
+			int gz = ((base[2] - jz) % n + n) % n;
+			for (int jy = 0; jy < order; jy++) {
+				int gy = ((base[1] - jy) % n + n) % n;
+				const std::complex<double>* row = &grid[n * (gy + n * gz)];
+				for (int jx = 0; jx < order; jx++) {
+					double phi = row[gx[jx]].real();
+					fx += dTheta[jx] * thetaY[jy] * thetaZ[jz] * phi;
+					fy += theta[jx] * dThetaY[jy] * thetaZ[jz] * phi;
+					fz += theta[jx] * thetaY[jy] * dThetaZ[jz] * phi;
+				}
+			}
+		}
+		//F = -dE/dr
+		recipForce[3 * i] = -charge * scale * fx;
+		recipForce[3 * i + 1] = -charge * scale * fy;
+		recipForce[3 * i + 2] = -charge * scale * fz;
+	}
+}
+
+}
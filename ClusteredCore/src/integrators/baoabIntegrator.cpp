@@ -0,0 +1,143 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "baoabIntegrator.h"
+
+namespace PSim {
+
+baoabIntegrator::baoabIntegrator(config* cfg) {
+
+	//Sets the name
+	name = "baoabIntegrator";
+
+	//Set the number of particles.
+	memSize = cfg->getParam<int>("nParticles", 1000);
+
+	//Sets the system temperature.
+	kT = cfg->getParam<double>("kT", 1.0);
+
+	//Sets the system drag.
+	gamma = cfg->getParam<double>("gamma", 0.5);
+
+	//Sets the integration time step.
+	setTimeStep(cfg->getParam<double>("timeStep", 0.001));
+	dtLast = 0.0;
+	dtSave = 0.0;
+
+	//Noise is keyed on the step, so no per particle generator is needed.
+	step = 0;
+	stepSave = 0;
+
+	seed = cfg->getParam<int>("seed", 90210);
+	queue = new noiseQueue(cfg, seed, memSize, 3, false);
+
+	chatterBox.consoleMessage("c1: " + tos(c1), 3);
+	chatterBox.consoleMessage("c2: " + tos(c2), 3);
+	chatterBox.consoleMessage("BAOAB integrator successfuly added.", 3);
+}
+
+baoabIntegrator::~baoabIntegrator() {
+	delete queue;
+}
+
+double baoabIntegrator::memoryEstimate(config* cfg) {
+	double n = cfg->getParam<int>("nParticles", 1000);
+	//Only the two noise buffers.
+	return 2 * 3 * n * sizeof(double);
+}
+
+bool baoabIntegrator::setTimeStep(double newDt) {
+	dt = newDt;
+	c1 = exp(-gamma * dt);
+	c2 = sqrt(1.0 - (c1 * c1));
+	return true;
+}
+
+int baoabIntegrator::nextSystem(PSim::particle** items, systemState* state) {
+	int nPart = state->nParticles;
+	cellBins* bins = state->bins;
+
+	queue->setIds((state->store != NULL) ? state->store->id : NULL);
+	//The whole step of noise, usually drawn during the last force pass.
+	const double* noise = queue->take(step);
+
+	//Closing half kick of the last step and opening half kick of this one.
+	double kick = 0.5 * (dtLast + dt);
+	double halfDt = 0.5 * dt;
+
+#pragma omp parallel for
+	for (int i = 0; i < nPart; i++) {
+		//Frozen particles are never integrated.
+		if (items[i]->isFrozen()) {
+			continue;
+		}
+
+		double m = 1.0 / items[i]->getMass();
+		double width = c2 * sqrt(kT * m);
+
+		//B
+		double vx = items[i]->getVX() + (kick * items[i]->getFX() * m);
+		double vy = items[i]->getVY() + (kick * items[i]->getFY() * m);
+		double vz = items[i]->getVZ() + (kick * items[i]->getFZ() * m);
+
+		//A O A. Both drifts are applied in one move so PBC is handled once.
+		type3<double> posNew = type3<double>();
+		posNew.x = items[i]->getX() + (halfDt * vx);
+		posNew.y = items[i]->getY() + (halfDt * vy);
+		posNew.z = items[i]->getZ() + (halfDt * vz);
+
+		vx = (c1 * vx) + (width * noise[3 * i]);
+		vy = (c1 * vy) + (width * noise[3 * i + 1]);
+		vz = (c1 * vz) + (width * noise[3 * i + 2]);
+
+		posNew.x += (halfDt * vx);
+		posNew.y += (halfDt * vy);
+		posNew.z += (halfDt * vz);
+		try {
+			items[i]->setPos(&posNew, state->boxSize);
+		} catch (...) {
+			failure.record();
+			continue;
+		}
+		if (bins != NULL) {
+			bins->bin(i, items[i]->getX(), items[i]->getY(), items[i]->getZ());
+		}
+
+		items[i]->setVX(vx);
+		items[i]->setVY(vy);
+		items[i]->setVZ(vz);
+	}
+	failure.rethrow();
+	//The positions are binned, so the system can skip its own hashing pass.
+	if (bins != NULL) {
+		bins->filled = true;
+	}
+
+	step++;
+	//Start on the next step's noise while the forces are evaluated.
+	queue->prefetch(step);
+	dtLast = dt;
+	return 0;
+}
+
+}
@@ -35,18 +35,26 @@ brownianIntegrator::brownianIntegrator(config* cfg) {
 	velCounter = 0;
 
 	//Create he memory blocks for mem and memCoor
-	memX = new double[memSize];
-	memY = new double[memSize];
-	memZ = new double[memSize];
-	memCorrX = new double[memSize];
-	memCorrY = new double[memSize];
-	memCorrZ = new double[memSize];
-
-	//Setup the particle random number generators.
-	rndGens = new fastRandom*[memSize];
-
-	for (int i=0; i<memSize; i++) {
-		rndGens[i] = new fastRandom();
+	memX = numa::allocate<double>(memSize, "integrator");
+	memY = numa::allocate<double>(memSize, "integrator");
+	memZ = numa::allocate<double>(memSize, "integrator");
+	memCorrX = numa::allocate<double>(memSize, "integrator");
+	memCorrY = numa::allocate<double>(memSize, "integrator");
+	memCorrZ = numa::allocate<double>(memSize, "integrator");
+
+	//Noise is keyed on the step, so no per particle generator is needed.
+	step = 0;
+	stepSave = 0;
+	noise = numa::allocate<double>((size_t) 3*memSize, "noise");
+
+	//One block for the SoA kernel arrays.
+	soaBlock = (double*) numa::reserve((size_t) 16*memSize*sizeof(double), "integrator");
+	double** arrays[16] = {&posX, &posY, &posZ, &oldX, &oldY, &oldZ, &frcX, &frcY, &frcZ,
+			&oldFX, &oldFY, &oldFZ, &invMass, &newX, &newY, &newZ};
+	for (int a = 0; a < 16; a++) {
+		*(arrays[a]) = &(soaBlock[(size_t) a*memSize]);
+		//Each plane is split over the threads like the particle loops.
+		numa::touch(*(arrays[a]), memSize);
 	}
 
 	//Sets the system temperature.
@@ -59,14 +67,70 @@ brownianIntegrator::brownianIntegrator(config* cfg) {
 	gamma = cfg->getParam<double>("gamma", 0.5);
 
 	//Sets the integration time step.
-	dt = cfg->getParam<double>("timeStep", 0.001);
+	setupCoefficients(cfg, cfg->getParam<double>("timeStep", 0.001));
+	dtLast = dt;
+
+	//Copies of the kick memory for rejected steps.
+	memSave = NULL;
+
+	seed = cfg->getParam<int>("seed", 90210);
+	queue = new noiseQueue(cfg, seed, memSize, 6, true);
+	outOfBounds = 0;
+
+	std::cout.precision(7);
+
+	chatterBox.consoleMessage("y: " + tos(y), 3);
+	chatterBox.consoleMessage("sig1: " + tos(sig1), 3);
+	chatterBox.consoleMessage("sig2: " + tos(sig2), 3);
+	chatterBox.consoleMessage("corr: " + tos(corr), 3);
+	chatterBox.consoleMessage("dev: " + tos(dev), 3);
+	chatterBox.consoleMessage("coEff0: " + tos(coEff0), 3);
+	chatterBox.consoleMessage("coEff1: " + tos(coEff1), 3);
+	chatterBox.consoleMessage("coEff2: " + tos(coEff2), 3);
+	chatterBox.consoleMessage("coEff3: " + tos(coEff3), 3);
+	chatterBox.consoleMessage("goy2: " + tos(goy2), 3);
+	chatterBox.consoleMessage("goy3: " + tos(goy3), 3);
+	chatterBox.consoleMessage("Brownian integrator successfuly added.", 3);
+}
+
+brownianIntegrator::~brownianIntegrator() {
+	numa::release(memX);
+	numa::release(memY);
+	numa::release(memZ);
+
+	numa::release(memCorrX);
+	numa::release(memCorrY);
+	numa::release(memCorrZ);
+
+	numa::release(noise);
+	delete queue;
+	numa::release(soaBlock);
+	numa::release(memSave);
+}
+
+double brownianIntegrator::memoryEstimate(config* cfg) {
+	double n = cfg->getParam<int>("nParticles", 1000);
+	//Mem and memCorr, the first step noise and the SoA kernel block.
+	double planes = 6 + 3 + 16;
+	//Saved history for rejected steps.
+	if (cfg->getParam<int>("adaptiveStep", 0)) {
+		planes += 6;
+	}
+	//Two noise buffers of six deviates.
+	planes += 2 * 6;
+	return planes * n * sizeof(double);
+}
+
+void brownianIntegrator::setupCoefficients(config* cfg, double newDt) {
+	dt = newDt;
 	dtInv = 1.0 / dt;
 
 	//Create vital variables
 	y = gamma * dt;
 
 	setupHigh(cfg);
-	if (gamma < 0.05) {
+	//The closed forms lose all precision once gamma * dt is tiny. An adaptive step can get there.
+	if (gamma < 0.05 || y < 1e-4) {
 		setupLow(cfg);
 	}
 	if (gamma == 0) {
@@ -79,33 +143,53 @@ brownianIntegrator::brownianIntegrator(config* cfg) {
 	sig2 = sqrt(-kT * sig2 / gamma2);
 	corr = (kT / (gamma2)) * (gn / (sig1 * sig2));
 	dev = sqrt(1.0 - (corr * corr));
+}
 
-	seed = cfg->getParam<int>("seed", 90210);
-
-	std::cout.precision(7);
+bool brownianIntegrator::setTimeStep(double newDt) {
+	//The coefficient setup does not read the config.
+	setupCoefficients(NULL, newDt);
+	return true;
+}
 
-	chatterBox.consoleMessage("y: " + tos(y), 3);
-	chatterBox.consoleMessage("sig1: " + tos(sig1), 3);
-	chatterBox.consoleMessage("sig2: " + tos(sig2), 3);
-	chatterBox.consoleMessage("corr: " + tos(corr), 3);
-	chatterBox.consoleMessage("dev: " + tos(dev), 3);
-	chatterBox.consoleMessage("coEff0: " + tos(coEff0), 3);
-	chatterBox.consoleMessage("coEff1: " + tos(coEff1), 3);
-	chatterBox.consoleMessage("coEff2: " + tos(coEff2), 3);
-	chatterBox.consoleMessage("coEff3: " + tos(coEff3), 3);
-	chatterBox.consoleMessage("goy2: " + tos(goy2), 3);
-	chatterBox.consoleMessage("goy3: " + tos(goy3), 3);
-	chatterBox.consoleMessage("Brownian integrator successfuly added.", 3);
+void brownianIntegrator::saveState() {
+	if (memSave == NULL) {
+		memSave = numa::allocate<double>((size_t) 6*memSize, "integrator");
+	}
+	double* mem[6] = {memX, memY, memZ, memCorrX, memCorrY, memCorrZ};
+	for (int a = 0; a < 6; a++) {
+		std::copy(mem[a], mem[a] + memSize, memSave + ((size_t) a*memSize));
+	}
+	velSave = velCounter;
+	dtSave = dtLast;
+	stepSave = step;
 }
 
-brownianIntegrator::~brownianIntegrator() {
-	delete[] memX;
-	delete[] memY;
-	delete[] memZ;
+void brownianIntegrator::restoreState() {
+	double* mem[6] = {memX, memY, memZ, memCorrX, memCorrY, memCorrZ};
+	for (int a = 0; a < 6; a++) {
+		std::copy(memSave + ((size_t) a*memSize), memSave + ((size_t) (a+1)*memSize), mem[a]);
+	}
+	velCounter = velSave;
+	dtLast = dtSave;
+	//The retry draws the same deviates, scaled to its own time step.
+	step = stepSave;
+	queue->rewind(step);
+}
 
-	delete[] memCorrX;
-	delete[] memCorrY;
-	delete[] memCorrZ;
+void brownianIntegrator::reorderInTeam(const int* order, int n) {
+	//The SoA block is free between steps, so it holds the copies.
+	double* mem[6] = {memX, memY, memZ, memCorrX, memCorrY, memCorrZ};
+	for (int a = 0; a < 6; a++) {
+		double* arr = mem[a];
+#pragma omp for
+		for (int k = 0; k < n; k++) {
+			soaBlock[k] = arr[order[k]];
+		}
+#pragma omp for
+		for (int k = 0; k < n; k++) {
+			arr[k] = soaBlock[k];
+		}
+	}
 }
 
 void brownianIntegrator::setupHigh(config* cfg) {
@@ -179,21 +263,45 @@ double brownianIntegrator::getWidth(double y) {
 }
 
 int brownianIntegrator::nextSystem(PSim::particle** items, systemState* state) {
+#pragma omp parallel
+	nextSystemInTeam(items, state);
+	failure.rethrow();
+	return 0;
+}
+
+int brownianIntegrator::nextSystemInTeam(PSim::particle** items, systemState* state) {
 	//Checks what method is needed.
 	if (state->currentTime == 0) {
 		firstStep(items, state);
 	} else {
 		normalStep(items, state);
 	}
+#pragma omp single
+	{
+		//The positions are binned, so the system can skip its own hashing pass.
+		if (state->bins != NULL) {
+			state->bins->filled = true;
+		}
+		step++;
+		dtLast = dt;
+		//Every thread has read the count by now.
+		outOfBounds = 0;
+		//Start on the next step's noise while the forces are evaluated.
+		queue->prefetch(step);
+	}
 	return 0;
 }
 
 int brownianIntegrator::firstStep(PSim::particle** items, systemState* state) {
-	//Add 4 threads to the team.
-#pragma omp parallel
-{
+	//Draw the whole step of noise at once.
+	philox::fillGaussianInTeam(seed, step, state->nParticles, 3, noise, (state->store != NULL) ? state->store->id : NULL);
+
 #pragma omp for
 	for (int i = 0; i < state->nParticles; i++) {
+		//Frozen particles are never integrated.
+		if (items[i]->isFrozen()) {
+			continue;
+		}
 
 		//SEE GUNSTEREN AND BERENDSEN 1981 EQ 2.26
 
@@ -201,11 +309,9 @@ int brownianIntegrator::firstStep(PSim::particle** items, systemState* state) {
 		memCorrY[i] = 0.0;
 		memCorrZ[i] = 0.0;
 
-		int threadSeed = seed*(i+1);
-
-		memX[i] = rndGens[i]->g250(threadSeed);
-		memY[i] = rndGens[i]->g250(threadSeed);
-		memZ[i] = rndGens[i]->g250(threadSeed);
+		memX[i] = noise[3*i];
+		memY[i] = noise[3*i+1];
+		memZ[i] = noise[3*i+2];
 
 		type3<double> posNew = type3<double>();
 		double m = 1.0 / items[i]->getMass();
@@ -215,86 +321,297 @@ int brownianIntegrator::firstStep(PSim::particle** items, systemState* state) {
 				+ (items[i]->getFY() * coEff3 * dt * dt * m) + (sig1 * memY[i]);
 		posNew.z = items[i]->getZ() + (items[i]->getVZ() * coEff1 * dt)
 				+ (items[i]->getFZ() * coEff3 * dt * dt * m) + (sig1 * memZ[i]);
-		items[i]->setPos(&posNew, state->boxSize);
-
+		try {
+			items[i]->setPos(&posNew, state->boxSize);
+		} catch (...) {
+			failure.record();
+			continue;
+		}
+		if (state->bins != NULL) {
+			state->bins->bin(i, items[i]->getX(), items[i]->getY(), items[i]->getZ());
+		}
 	}
-}
 	return 0;
 }
 
 int brownianIntegrator::normalStep(PSim::particle** items, systemState* state) {
 
+	int nPart = state->nParticles;
 	double dt2 = dt * dt;
 	double c0 = 1.0 + coEff0;
-#pragma omp parallel
-{
-#pragma omp for
-	for (int i = 0; i < state->nParticles; i++) {
-		//SEE GUNSTEREN AND BERENDSEN 1981 EQ 2.26
-		//New random walk.
-
-		int threadSeed = seed*(i+1);
 
-		memCorrX[i] = rndGens[i]->g250(threadSeed);
-		memCorrY[i] = rndGens[i]->g250(threadSeed);
-		memCorrZ[i] = rndGens[i]->g250(threadSeed);
+	//Key the noise on the particle ids, which follow the particles when storage is reordered.
+#pragma omp single nowait
+	queue->setIds((state->store != NULL) ? state->store->id : NULL);
+	//The whole step of noise, usually drawn during the last force pass.
+	const double* kicks = queue->takeInTeam(step);
+
+	gather(items, state);
+
+	//The old positions stand for the velocity over the last step. Rescale them if the step changed.
+	if (dt != dtLast) {
+		double ratio = dt / dtLast;
+#pragma omp for simd
+		for (int i = 0; i < nPart; i++) {
+			oldX[i] = posX[i] - ((posX[i] - oldX[i]) * ratio);
+			oldY[i] = posY[i] - ((posY[i] - oldY[i]) * ratio);
+			oldZ[i] = posZ[i] - ((posZ[i] - oldZ[i]) * ratio);
+		}
+	}
 
+	//Local copies of the members, so the compiler knows the arrays do not alias them.
+	const double s1 = sig1;
+	const double s2 = sig2;
+	const double cr = corr;
+	const double dv = dev;
+	const double e0 = coEff0;
+	const double e1 = coEff1;
+	const double e2 = coEff2;
+	const double* kickX0 = kicks;
+	const double* kickY0 = kicks + nPart;
+	const double* kickZ0 = kicks + (2 * nPart);
+	const double* kickX1 = kicks + (3 * nPart);
+	const double* kickY1 = kicks + (4 * nPart);
+	const double* kickZ1 = kicks + (5 * nPart);
+	double* mX = memX;
+	double* mY = memY;
+	double* mZ = memZ;
+	double* mCX = memCorrX;
+	double* mCY = memCorrY;
+	double* mCZ = memCorrZ;
+	const double* pX = posX;
+	const double* pY = posY;
+	const double* pZ = posZ;
+	const double* pX0 = oldX;
+	const double* pY0 = oldY;
+	const double* pZ0 = oldZ;
+	const double* fX = frcX;
+	const double* fY = frcY;
+	const double* fZ = frcZ;
+	const double* fX0 = oldFX;
+	const double* fY0 = oldFY;
+	const double* fZ0 = oldFZ;
+	const double* mInv = invMass;
+	double* nX = newX;
+	double* nY = newY;
+	double* nZ = newZ;
+
+#pragma omp for simd
+	for (int i = 0; i < nPart; i++) {
+		//SEE GUNSTEREN AND BERENDSEN 1981 EQ 2.26
 		//Correlation to last random walk.
-		memCorrX[i] = sig2 * ((corr * memX[i]) + (dev * memCorrX[i]));
-		memCorrY[i] = sig2 * ((corr * memY[i]) + (dev * memCorrY[i]));
-		memCorrZ[i] = sig2 * ((corr * memZ[i]) + (dev * memCorrZ[i]));
+		mCX[i] = s2 * ((cr * mX[i]) + (dv * kickX0[i]));
+		mCY[i] = s2 * ((cr * mY[i]) + (dv * kickY0[i]));
+		mCZ[i] = s2 * ((cr * mZ[i]) + (dv * kickZ0[i]));
 
-		memX[i] = rndGens[i]->g250(threadSeed);
-		memY[i] = rndGens[i]->g250(threadSeed);
-		memZ[i] = rndGens[i]->g250(threadSeed);
-
-		double m = 1.0 / items[i]->getMass();
-		double c1 = m * dt2 * coEff1;
-		double c2 = m * dt2 * coEff2;
+		//New random walk.
+		mX[i] = kickX1[i];
+		mY[i] = kickY1[i];
+		mZ[i] = kickZ1[i];
 
-		type3<double> posNew = type3<double>();
+		double c1 = mInv[i] * dt2 * e1;
+		double c2 = mInv[i] * dt2 * e2;
 
 		//Run the integration routine.
-		posNew.x = (c0 * items[i]->getX());
-		posNew.x -= (coEff0 * items[i]->getX0());
-		posNew.x += (c1 * items[i]->getFX());
-		posNew.x += (c2 * (items[i]->getFX() - items[i]->getFX0()));
-		posNew.x += (sig1 * memX[i]) + (coEff0 * memCorrX[i]);
-
-		posNew.y = (c0 * items[i]->getY());
-		posNew.y -= (coEff0 * items[i]->getY0());
-		posNew.y += (c1 * items[i]->getFY());
-		posNew.y += (c2 * (items[i]->getFY() - items[i]->getFY0()));
-		posNew.y += (sig1 * memY[i]) + (coEff0 * memCorrY[i]);
-
-		posNew.z = (c0 * items[i]->getZ());
-		posNew.z -= (coEff0 * items[i]->getZ0());
-		posNew.z += (c1 * items[i]->getFZ());
-		posNew.z += (c2 * (items[i]->getFZ() - items[i]->getFZ0()));
-		posNew.z += (sig1 * memZ[i]) + (coEff0 * memCorrZ[i]);
-
-		//Velocity is not needed for brownianIntegration.
-		//Run velocity integration at the same frequency as
-		//the temperature/energy analysis routine.
-		//-------------------------------------------------
-		//For best performance use
-		//velFreq = outputFreq.
-		//-------------------------------------------------
-		//If using a velocity dependent force use
-		//velFreq = 0.
-		//-------------------------------------------------
-		//For all other cases do whatever.
-
-		(velFreq == 0 || velCounter == velFreq) ? velocityStep(items, i, &posNew, dt, state->boxSize) :items[i]->setPos(&posNew, state->boxSize);
+		double x = (c0 * pX[i]);
+		x -= (e0 * pX0[i]);
+		x += (c1 * fX[i]);
+		x += (c2 * (fX[i] - fX0[i]));
+		x += (s1 * mX[i]) + (e0 * mCX[i]);
+		nX[i] = x;
+
+		double y = (c0 * pY[i]);
+		y -= (e0 * pY0[i]);
+		y += (c1 * fY[i]);
+		y += (c2 * (fY[i] - fY0[i]));
+		y += (s1 * mY[i]) + (e0 * mCY[i]);
+		nY[i] = y;
+
+		double z = (c0 * pZ[i]);
+		z -= (e0 * pZ0[i]);
+		z += (c1 * fZ[i]);
+		z += (c2 * (fZ[i] - fZ0[i]));
+		z += (s1 * mZ[i]) + (e0 * mCZ[i]);
+		nZ[i] = z;
 	}
-}
+
+	//Velocity is not needed for brownianIntegration.
+	//Run velocity integration at the same frequency as
+	//the temperature/energy analysis routine.
+	//-------------------------------------------------
+	//For best performance use
+	//velFreq = outputFreq.
+	//-------------------------------------------------
+	//If using a velocity dependent force use
+	//velFreq = 0.
+	//-------------------------------------------------
+	//For all other cases do whatever.
+	if (velFreq == 0 || velCounter == velFreq) {
+#pragma omp for
+		for (int i = 0; i < nPart; i++) {
+			//Frozen particles are never integrated.
+			if (!items[i]->isFrozen()) {
+				type3<double> posNew = type3<double>(newX[i], newY[i], newZ[i]);
+				try {
+					velocityStep(items, i, &posNew, dt, state->boxSize);
+				} catch (...) {
+					failure.record();
+					continue;
+				}
+				if (state->bins != NULL) {
+					state->bins->bin(i, items[i]->getX(), items[i]->getY(), items[i]->getZ());
+				}
+			}
+		}
+	} else {
+		scatter(items, state);
+	}
+
 	//Manage velocity output counter.
+#pragma omp single
 	(velCounter == velFreq) ? velCounter = 0 : velCounter++;
 
 	return 0;
 
 }
 
+void brownianIntegrator::gather(PSim::particle** items, systemState* state) {
+	int nPart = state->nParticles;
+
+	//Stream straight from the store when the particles share one.
+	if (state->store != NULL) {
+		const particleStore* store = state->store;
+		const double* sX = store->x;
+		const double* sY = store->y;
+		const double* sZ = store->z;
+		const double* sX0 = store->x0;
+		const double* sY0 = store->y0;
+		const double* sZ0 = store->z0;
+		const double* frc = store->force;
+		const double* frc0 = store->force0;
+		const double* mass = store->mass;
+#pragma omp for simd
+		for (int i = 0; i < nPart; i++) {
+			posX[i] = sX[i];
+			posY[i] = sY[i];
+			posZ[i] = sZ[i];
+			oldX[i] = sX0[i];
+			oldY[i] = sY0[i];
+			oldZ[i] = sZ0[i];
+			frcX[i] = frc[3*i];
+			frcY[i] = frc[3*i+1];
+			frcZ[i] = frc[3*i+2];
+			oldFX[i] = frc0[3*i];
+			oldFY[i] = frc0[3*i+1];
+			oldFZ[i] = frc0[3*i+2];
+			invMass[i] = 1.0 / mass[i];
+		}
+		return;
+	}
+
+#pragma omp for
+	for (int i = 0; i < nPart; i++) {
+		posX[i] = items[i]->getX();
+		posY[i] = items[i]->getY();
+		posZ[i] = items[i]->getZ();
+		oldX[i] = items[i]->getX0();
+		oldY[i] = items[i]->getY0();
+		oldZ[i] = items[i]->getZ0();
+		frcX[i] = items[i]->getFX();
+		frcY[i] = items[i]->getFY();
+		frcZ[i] = items[i]->getFZ();
+		oldFX[i] = items[i]->getFX0();
+		oldFY[i] = items[i]->getFY0();
+		oldFZ[i] = items[i]->getFZ0();
+		invMass[i] = 1.0 / items[i]->getMass();
+	}
+}
+
+void brownianIntegrator::scatter(PSim::particle** items, systemState* state) {
+	int nPart = state->nParticles;
+	double boxSize = state->boxSize;
+	cellBins* bins = state->bins;
+	particleStore* store = state->store;
+
+	//Local copies of the members, so the compiler knows the arrays do not alias them.
+	const double* nX = newX;
+	const double* nY = newY;
+	const double* nZ = newZ;
+	double* pX = posX;
+	double* pY = posY;
+	double* pZ = posZ;
+	double* pX0 = oldX;
+	double* pY0 = oldY;
+	double* pZ0 = oldZ;
+
+	//Each thread takes its own share, so its count can be kept locally and added once.
+	int team = omp_get_num_threads();
+	int t = omp_get_thread_num();
+	int first = ((long) nPart * t) / team;
+	int last = ((long) nPart * (t + 1)) / team;
+	int bad = 0;
+
+	//Wrap the new positions and find the matching old positions.
+#pragma omp simd reduction(+:bad)
+	for (int i = first; i < last; i++) {
+		double x = PSim::util::wrapPBC(nX[i], boxSize);
+		double y = PSim::util::wrapPBC(nY[i], boxSize);
+		double z = PSim::util::wrapPBC(nZ[i], boxSize);
+
+		pX0[i] = PSim::util::wrapPBC0(pX[i], x, boxSize);
+		pY0[i] = PSim::util::wrapPBC0(pY[i], y, boxSize);
+		pZ0[i] = PSim::util::wrapPBC0(pZ[i], z, boxSize);
+
+		pX[i] = x;
+		pY[i] = y;
+		pZ[i] = z;
+
+		bad += (x < 0.0) | (x >= boxSize) | (y < 0.0) | (y >= boxSize) | (z < 0.0) | (z >= boxSize);
+	}
+#pragma omp atomic
+	outOfBounds += bad;
+#pragma omp barrier
+
+	//A particle moved more than a box length.
+	if (outOfBounds > 0) {
+#pragma omp single
+		try {
+			for (int i = 0; i < nPart; i++) {
+				if (!items[i]->isFrozen()) {
+					type3<double> pos = type3<double>(posX[i], posY[i], posZ[i]);
+					if ((pos.x < 0.0) || (pos.x >= boxSize) || (pos.y < 0.0) || (pos.y >= boxSize) || (pos.z < 0.0) || (pos.z >= boxSize)) {
+						PSim::error::throwParticleBoundsError(&pos, (int) items[i]->getName());
+					}
+				}
+			}
+		} catch (...) {
+			failure.record();
+		}
+	}
+
+	bool anyFrozen = (state->nFrozen > 0);
+#pragma omp for
+	for (int i = 0; i < nPart; i++) {
+		//Frozen particles are never integrated.
+		if (anyFrozen && items[i]->isFrozen()) {
+			continue;
+		}
+		if (store != NULL) {
+			store->x[i] = posX[i];
+			store->y[i] = posY[i];
+			store->z[i] = posZ[i];
+			store->x0[i] = oldX[i];
+			store->y0[i] = oldY[i];
+			store->z0[i] = oldZ[i];
+		} else {
+			items[i]->setPosRaw(type3<double>(posX[i], posY[i], posZ[i]), type3<double>(oldX[i], oldY[i], oldZ[i]));
+		}
+		if (bins != NULL) {
+			bins->bin(i, posX[i], posY[i], posZ[i]);
+		}
+	}
+}
+
 void brownianIntegrator::velocityStep(PSim::particle** items, int i,
 		type3<double>* posNew0, double dt, double boxSize) {
 
@@ -302,9 +619,10 @@ void brownianIntegrator::velocityStep(PSim::particle** items, int i,
 
 	//Current position and previous position are already PBC safe.
 	//Their difference is also already PBC safe.
-	double dx0 = items[i]->getX() - items[i]->getX0();
-	double dy0 = items[i]->getY() - items[i]->getY0();
-	double dz0 = items[i]->getZ() - items[i]->getZ0();
+	//The gathered history is rescaled to this time step, so the difference is too.
+	double dx0 = posX[i] - oldX[i];
+	double dy0 = posY[i] - oldY[i];
+	double dz0 = posZ[i] - oldZ[i];
 
 	//Make the new position PBC safe.
 	double xNew = PSim::util::safeMod(posNew0->x, boxSize);
@@ -0,0 +1,117 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+#include "ermakIntegrator.h"
+
+namespace PSim {
+
+ermakIntegrator::ermakIntegrator(config* cfg) {
+
+	//Sets the name
+	name = "ermakIntegrator";
+
+	//Set the number of particles.
+	memSize = cfg->getParam<int>("nParticles", 1000);
+
+	//Sets the system temperature.
+	kT = cfg->getParam<double>("kT", 1.0);
+
+	//Sets the system drag.
+	gamma = cfg->getParam<double>("gamma", 0.5);
+
+	//Sets the integration time step.
+	dt = cfg->getParam<double>("timeStep", 0.001);
+
+	//Noise is keyed on the step, so no per particle generator is needed.
+	step = 0;
+	stepSave = 0;
+
+	seed = cfg->getParam<int>("seed", 90210);
+	queue = new noiseQueue(cfg, seed, memSize, 3, false);
+
+	//The scheme is valid on times well past the velocity relaxation.
+	chatterBox.consoleMessage("Velocity relaxation time: " + tos(1.0 / gamma), 3);
+	chatterBox.consoleMessage("Ermak-McCammon integrator successfuly added.", 3);
+}
+
+ermakIntegrator::~ermakIntegrator() {
+	delete queue;
+}
+
+double ermakIntegrator::memoryEstimate(config* cfg) {
+	double n = cfg->getParam<int>("nParticles", 1000);
+	//Only the two noise buffers.
+	return 2 * 3 * n * sizeof(double);
+}
+
+bool ermakIntegrator::setTimeStep(double newDt) {
+	dt = newDt;
+	return true;
+}
+
+int ermakIntegrator::nextSystem(PSim::particle** items, systemState* state) {
+	int nPart = state->nParticles;
+	cellBins* bins = state->bins;
+
+	queue->setIds((state->store != NULL) ? state->store->id : NULL);
+	//The whole step of noise, usually drawn during the last force pass.
+	const double* noise = queue->take(step);
+
+#pragma omp parallel for
+	for (int i = 0; i < nPart; i++) {
+		//Frozen particles are never integrated.
+		if (items[i]->isFrozen()) {
+			continue;
+		}
+
+		//SEE ERMAK AND MCCAMMON 1978 EQ 11 WITHOUT HYDRODYNAMICS
+		double mobility = 1.0 / (items[i]->getMass() * gamma);
+		double drift = dt * mobility;
+		double width = sqrt(2.0 * kT * dt * mobility);
+
+		type3<double> posNew = type3<double>();
+		posNew.x = items[i]->getX() + (drift * items[i]->getFX()) + (width * noise[3 * i]);
+		posNew.y = items[i]->getY() + (drift * items[i]->getFY()) + (width * noise[3 * i + 1]);
+		posNew.z = items[i]->getZ() + (drift * items[i]->getFZ()) + (width * noise[3 * i + 2]);
+		try {
+			items[i]->setPos(&posNew, state->boxSize);
+		} catch (...) {
+			failure.record();
+			continue;
+		}
+		if (bins != NULL) {
+			bins->bin(i, items[i]->getX(), items[i]->getY(), items[i]->getZ());
+		}
+	}
+	failure.rethrow();
+	//The positions are binned, so the system can skip its own hashing pass.
+	if (bins != NULL) {
+		bins->filled = true;
+	}
+
+	step++;
+	//Start on the next step's noise while the forces are evaluated.
+	queue->prefetch(step);
+	return 0;
+}
+
+}
@@ -0,0 +1,460 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+#include "hydroIntegrator.h"
+
+namespace PSim {
+
+hydroIntegrator::hydroIntegrator(config* cfg) {
+
+	//Sets the name
+	name = "hydroIntegrator";
+
+	//Set the number of particles.
+	memSize = cfg->getParam<int>("nParticles", 1000);
+
+	//Sets the system temperature.
+	kT = cfg->getParam<double>("kT", 1.0);
+
+	//Set the mass.
+	mass = cfg->getParam<double>("mass", 1.0);
+
+	//Sets the system drag.
+	gamma = cfg->getParam<double>("gamma", 0.5);
+
+	//Sets the integration time step.
+	dt = cfg->getParam<double>("timeStep", 0.001);
+
+	mobility = 1.0 / (mass * gamma);
+	noiseWidth = sqrt(2.0 * kT * dt);
+
+	//RPY decays as 1/r so the cutoff should be several diameters.
+	cutOff = cfg->getParam<double>("hydroCutOff", 4.0);
+	cutOffSquared = cutOff * cutOff;
+
+	//Lanczos iterations and relative tolerance for the noise.
+	maxKrylov = cfg->getParam<int>("hydroKrylov", 30);
+	tolerance = cfg->getParam<double>("hydroTolerance", 1e-4);
+	maxKrylov = (maxKrylov < 2) ? 2 : maxKrylov;
+	warnedKrylov = false;
+
+	//Create the memory blocks.
+	pos = numa::allocate<double>(3 * memSize, "integrator");
+	radius = numa::allocate<double>(memSize, "integrator");
+	force = numa::allocate<double>(3 * memSize, "integrator");
+	drift = numa::allocate<double>(3 * memSize, "integrator");
+	brownian = numa::allocate<double>(3 * memSize, "integrator");
+	basis = (double*) numa::reserve((size_t) 3 * memSize * maxKrylov * sizeof(double), "integrator");
+	for (int k = 0; k < maxKrylov; k++) {
+		//One vector at a time, so each thread touches the rows of its own particles.
+		numa::touch(basis + ((size_t) k * 3 * memSize), 3 * memSize);
+	}
+	work = numa::allocate<double>(3 * memSize, "integrator");
+
+	cellScale = 0;
+	cellWidth = 0;
+
+	//Noise is keyed on the step, so no per particle generator is needed.
+	step = 0;
+	stepSave = 0;
+
+	seed = cfg->getParam<int>("seed", 90210);
+	queue = new noiseQueue(cfg, seed, memSize, 3, false);
+
+	chatterBox.consoleMessage("mobility: " + tos(mobility), 3);
+	chatterBox.consoleMessage("hydroCutOff: " + tos(cutOff), 3);
+	chatterBox.consoleMessage("hydroKrylov: " + tos(maxKrylov), 3);
+	chatterBox.consoleMessage("Hydrodynamic integrator successfuly added.", 3);
+}
+
+hydroIntegrator::~hydroIntegrator() {
+	numa::release(pos);
+	numa::release(radius);
+	numa::release(force);
+	numa::release(drift);
+	delete queue;
+	numa::release(brownian);
+	numa::release(basis);
+	numa::release(work);
+}
+
+double hydroIntegrator::memoryEstimate(config* cfg) {
+	double n = cfg->getParam<int>("nParticles", 1000);
+	int krylov = std::max(cfg->getParam<int>("hydroKrylov", 30), 2);
+	//Gathered particle data, the lanczos basis and work vector, and the noise buffers.
+	double vectors = 3 + 1 + 3 + 3 + 3 + (3 * krylov) + 3 + (2 * 3);
+	//The cell list and the frozen flags.
+	return (vectors * n * sizeof(double)) + (n * (sizeof(int) + sizeof(char)));
+}
+
+double hydroIntegrator::dot(const double* a, const double* b, int n) {
+	double sum = 0.0;
+#pragma omp parallel for reduction(+:sum)
+	for (int k = 0; k < n; k++) {
+		sum += a[k] * b[k];
+	}
+	return sum;
+}
+
+void hydroIntegrator::buildCells(PSim::particle** items, systemState* state) {
+	int boxSize = state->boxSize;
+
+	//The cutoff cannot see past the nearest image.
+	if (cutOff > 0.5 * boxSize) {
+		cutOff = 0.5 * boxSize;
+		cutOffSquared = cutOff * cutOff;
+		chatterBox.consoleMessage("hydroCutOff reduced to half the box: " + tos(cutOff), 1);
+	}
+
+	//Fewer than three cells per side would double count neighbors. Use one cell instead.
+	cellScale = int(floor(boxSize / cutOff));
+	cellScale = (cellScale < 3) ? 1 : cellScale;
+	cellWidth = double(boxSize) / double(cellScale);
+
+	cellHead.assign(cellScale * cellScale * cellScale, -1);
+	cellNext.resize(state->nParticles);
+	frozen.resize(state->nParticles);
+
+	for (int i = 0; i < state->nParticles; i++) {
+		pos[3 * i] = items[i]->getX();
+		pos[3 * i + 1] = items[i]->getY();
+		pos[3 * i + 2] = items[i]->getZ();
+		radius[i] = items[i]->getRadius();
+		force[3 * i] = items[i]->getFX();
+		force[3 * i + 1] = items[i]->getFY();
+		force[3 * i + 2] = items[i]->getFZ();
+
+		//Frozen particles have no force from the pair kernel and are not coupled.
+		frozen[i] = items[i]->isFrozen();
+		cellNext[i] = -1;
+		if (frozen[i]) {
+			continue;
+		}
+		int cx = std::min(int(pos[3 * i] / cellWidth), cellScale - 1);
+		int cy = std::min(int(pos[3 * i + 1] / cellWidth), cellScale - 1);
+		int cz = std::min(int(pos[3 * i + 2] / cellWidth), cellScale - 1);
+		int hash = cx + cellScale * (cy + cellScale * cz);
+		cellNext[i] = cellHead[hash];
+		cellHead[hash] = i;
+	}
+}
+
+void hydroIntegrator::addPair(int i, int j, const double* in, double* sum, double boxSize) {
+	//Minimum image separation.
+	double d[3];
+	for (int k = 0; k < 3; k++) {
+		d[k] = pos[3 * j + k] - pos[3 * i + k];
+		d[k] -= boxSize * floor((d[k] / boxSize) + 0.5);
+	}
+	double rSquared = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+	if (rSquared >= cutOffSquared) {
+		return;
+	}
+
+	//SEE ROTNE AND PRAGER 1969, YAMAKAWA 1970
+	double r = sqrt(rSquared);
+	double rInv = 1.0 / r;
+	double a = 0.5 * (radius[i] + radius[j]);
+	double iso;
+	double dyad;
+	if (r >= 2.0 * a) {
+		double ar = a * rInv;
+		double ar3 = ar * ar * ar;
+		iso = (0.75 * ar) + (0.5 * ar3);
+		dyad = (0.75 * ar) - (1.5 * ar3);
+	} else {
+		//Overlapping spheres.
+		double ra = r / a;
+		iso = 1.0 - (9.0 / 32.0) * ra;
+		dyad = (3.0 / 32.0) * ra;
+	}
+
+	//Wendland taper. Keeps the truncated tensor positive definite.
+	double q = r / cutOff;
+	double taper = (1.0 - q) * (1.0 - q);
+	taper *= taper * ((4.0 * q) + 1.0);
+	iso *= taper;
+	dyad *= taper;
+
+	double proj = (d[0] * in[3 * j] + d[1] * in[3 * j + 1] + d[2] * in[3 * j + 2]) * rInv * rInv;
+	for (int k = 0; k < 3; k++) {
+		sum[k] += (iso * in[3 * j + k]) + (dyad * proj * d[k]);
+	}
+}
+
+void hydroIntegrator::applyMobility(const double* in, double* out, systemState* state) {
+	int nPart = state->nParticles;
+	double boxSize = state->boxSize;
+	int scale = cellScale;
+
+#pragma omp parallel for schedule(dynamic, 64)
+	for (int i = 0; i < nPart; i++) {
+		//Frozen rows are zero.
+		if (frozen[i]) {
+			out[3 * i] = 0.0;
+			out[3 * i + 1] = 0.0;
+			out[3 * i + 2] = 0.0;
+			continue;
+		}
+		double sum[3] = {in[3 * i], in[3 * i + 1], in[3 * i + 2]};
+
+		if (scale == 1) {
+			for (int j = 0; j < nPart; j++) {
+				if (j != i && !frozen[j]) {
+					addPair(i, j, in, sum, boxSize);
+				}
+			}
+		} else {
+			int cx = std::min(int(pos[3 * i] / cellWidth), scale - 1);
+			int cy = std::min(int(pos[3 * i + 1] / cellWidth), scale - 1);
+			int cz = std::min(int(pos[3 * i + 2] / cellWidth), scale - 1);
+			for (int x = -1; x <= 1; x++) {
+				for (int y = -1; y <= 1; y++) {
+					for (int z = -1; z <= 1; z++) {
+						int hx = (cx + x + scale) % scale;
+						int hy = (cy + y + scale) % scale;
+						int hz = (cz + z + scale) % scale;
+						for (int j = cellHead[hx + scale * (hy + scale * hz)]; j != -1; j = cellNext[j]) {
+							if (j != i) {
+								addPair(i, j, in, sum, boxSize);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		out[3 * i] = mobility * sum[0];
+		out[3 * i + 1] = mobility * sum[1];
+		out[3 * i + 2] = mobility * sum[2];
+	}
+}
+
+void hydroIntegrator::tridiagonalSqrt(const double* diag, const double* offDiag, int n, double* result, double* space) {
+	//Dense copy of T and its eigenvectors.
+	double* A = space;
+	double* V = space + (n * n);
+	std::fill(space, space + (2 * n * n), 0.0);
+	for (int i = 0; i < n; i++) {
+		A[i * n + i] = diag[i];
+		V[i * n + i] = 1.0;
+		if (i + 1 < n) {
+			A[i * n + i + 1] = offDiag[i];
+			A[(i + 1) * n + i] = offDiag[i];
+		}
+	}
+
+	//Cyclic jacobi rotations. T is at most hydroKrylov wide.
+	for (int sweep = 0; sweep < 50; sweep++) {
+		double off = 0.0;
+		for (int p = 0; p < n; p++) {
+			for (int q = p + 1; q < n; q++) {
+				off += A[p * n + q] * A[p * n + q];
+			}
+		}
+		if (off < 1e-24) {
+			break;
+		}
+		for (int p = 0; p < n; p++) {
+			for (int q = p + 1; q < n; q++) {
+				double apq = A[p * n + q];
+				if (fabs(apq) < 1e-300) {
+					continue;
+				}
+				double theta = (A[q * n + q] - A[p * n + p]) / (2.0 * apq);
+				double t = ((theta >= 0) ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0);
+				double s = t * c;
+				for (int k = 0; k < n; k++) {
+					double akp = A[k * n + p];
+					double akq = A[k * n + q];
+					A[k * n + p] = c * akp - s * akq;
+					A[k * n + q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < n; k++) {
+					double apk = A[p * n + k];
+					double aqk = A[q * n + k];
+					A[p * n + k] = c * apk - s * aqk;
+					A[q * n + k] = s * apk + c * aqk;
+				}
+				for (int k = 0; k < n; k++) {
+					double vkp = V[k * n + p];
+					double vkq = V[k * n + q];
+					V[k * n + p] = c * vkp - s * vkq;
+					V[k * n + q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	//A cutoff RPY tensor is not always positive definite. Clamp the negative modes.
+	for (int i = 0; i < n; i++) {
+		result[i] = 0.0;
+	}
+	for (int j = 0; j < n; j++) {
+		double lambda = A[j * n + j];
+		double root = (lambda > 0.0) ? sqrt(lambda) : 0.0;
+		double w = root * V[j];
+		for (int i = 0; i < n; i++) {
+			result[i] += V[i * n + j] * w;
+		}
+	}
+}
+
+void hydroIntegrator::sqrtMobility(const double* z, double* out, systemState* state) {
+	int n = 3 * state->nParticles;
+	//Only the mobile part of the kicks. The frozen rows of the root are zero.
+	double zNorm = 0.0;
+#pragma omp parallel for reduction(+:zNorm)
+	for (int k = 0; k < n; k++) {
+		zNorm += (frozen[k / 3]) ? 0.0 : z[k] * z[k];
+	}
+	zNorm = sqrt(zNorm);
+
+	scratch.reset();
+	double* diag = scratch.allocate<double>(maxKrylov);
+	double* offDiag = scratch.allocate<double>(maxKrylov);
+	double* coEff = scratch.allocate<double>(maxKrylov);
+	double* coEffOld = scratch.allocate<double>(maxKrylov);
+	double* space = scratch.allocate<double>(2 * maxKrylov * maxKrylov);
+	double* lists[4] = {diag, offDiag, coEff, coEffOld};
+	for (int l = 0; l < 4; l++) {
+		std::fill(lists[l], lists[l] + maxKrylov, 0.0);
+	}
+
+	//First lanczos vector.
+#pragma omp parallel for
+	for (int k = 0; k < n; k++) {
+		basis[k] = (frozen[k / 3]) ? 0.0 : z[k] / zNorm;
+	}
+
+	int m = 0;
+	for (int iter = 0; iter < maxKrylov; iter++) {
+		double* v = basis + ((size_t) iter * n);
+		double* vOld = (iter > 0) ? basis + ((size_t) (iter - 1) * n) : NULL;
+		double betaOld = (iter > 0) ? offDiag[iter - 1] : 0.0;
+
+		applyMobility(v, work, state);
+		if (iter > 0) {
+#pragma omp parallel for
+			for (int k = 0; k < n; k++) {
+				work[k] -= betaOld * vOld[k];
+			}
+		}
+		diag[iter] = dot(v, work, n);
+#pragma omp parallel for
+		for (int k = 0; k < n; k++) {
+			work[k] -= diag[iter] * v[k];
+		}
+		offDiag[iter] = sqrt(dot(work, work, n));
+		m = iter + 1;
+
+		//Converged when the krylov coefficients stop changing.
+		tridiagonalSqrt(diag, offDiag, m, coEff, space);
+		double diff = 0.0;
+		double total = 0.0;
+		for (int j = 0; j < m; j++) {
+			diff += (coEff[j] - coEffOld[j]) * (coEff[j] - coEffOld[j]);
+			total += coEff[j] * coEff[j];
+		}
+		std::copy(coEff, coEff + maxKrylov, coEffOld);
+		if ((iter > 0 && diff < tolerance * tolerance * total) || offDiag[iter] < 1e-12 || m == maxKrylov) {
+			break;
+		}
+
+		double* vNew = basis + ((size_t) (iter + 1) * n);
+		double betaInv = 1.0 / offDiag[iter];
+#pragma omp parallel for
+		for (int k = 0; k < n; k++) {
+			vNew[k] = work[k] * betaInv;
+		}
+	}
+	if (m == maxKrylov && !warnedKrylov) {
+		chatterBox.consoleMessage("Lanczos noise did not converge in hydroKrylov iterations.", 1);
+		warnedKrylov = true;
+	}
+
+	//M^(1/2) z = |z| V T^(1/2) e1
+#pragma omp parallel for
+	for (int k = 0; k < n; k++) {
+		double sum = 0.0;
+		for (int j = 0; j < m; j++) {
+			sum += coEff[j] * basis[((size_t) j * n) + k];
+		}
+		out[k] = zNorm * sum;
+	}
+}
+
+bool hydroIntegrator::setTimeStep(double newDt) {
+	//The overdamped step carries nothing between steps, so only the widths change.
+	dt = newDt;
+	noiseWidth = sqrt(2.0 * kT * dt);
+	return true;
+}
+
+int hydroIntegrator::nextSystem(PSim::particle** items, systemState* state) {
+	int nPart = state->nParticles;
+	cellBins* bins = state->bins;
+
+	buildCells(items, state);
+
+	queue->setIds((state->store != NULL) ? state->store->id : NULL);
+	//Independent gaussian kicks.
+	const double* noise = queue->take(step);
+
+	//Deterministic and brownian displacements.
+	applyMobility(force, drift, state);
+	sqrtMobility(noise, brownian, state);
+
+#pragma omp parallel for
+	for (int i = 0; i < nPart; i++) {
+		//Frozen particles stay put.
+		if (frozen[i]) {
+			continue;
+		}
+		type3<double> posNew = type3<double>();
+		posNew.x = pos[3 * i] + (dt * drift[3 * i]) + (noiseWidth * brownian[3 * i]);
+		posNew.y = pos[3 * i + 1] + (dt * drift[3 * i + 1]) + (noiseWidth * brownian[3 * i + 1]);
+		posNew.z = pos[3 * i + 2] + (dt * drift[3 * i + 2]) + (noiseWidth * brownian[3 * i + 2]);
+		try {
+			items[i]->setPos(&posNew, state->boxSize);
+		} catch (...) {
+			failure.record();
+			continue;
+		}
+		if (bins != NULL) {
+			bins->bin(i, items[i]->getX(), items[i]->getY(), items[i]->getZ());
+		}
+	}
+	failure.rethrow();
+	//The positions are binned, so the system can skip its own hashing pass.
+	if (bins != NULL) {
+		bins->filled = true;
+	}
+
+	step++;
+	//Start on the next step's noise while the forces are evaluated.
+	queue->prefetch(step);
+	return 0;
+}
+
+}
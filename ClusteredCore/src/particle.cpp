@@ -34,15 +34,15 @@ particle::particle(int pid) {
 
 	coorNumber = 0;
 
-	pos = type3<double>();
-	pos0 = type3<double>();
-	vel = type3<double>();
-	frc = type3<double>();
-	frc0 = type3<double>();
+	//A particle on its own keeps its data in a one slot store.
+	store = new particleStore(1);
+	slot = 0;
+	ownsStore = true;
+	store->id[slot] = pid;
 	cll = type3<int>(-1,-1,-1);
 
-	r = 0.0;
-	m = 0.0;
+	species = 0;
+	frozen = false;
 
 	coorNumber = 0;
 
@@ -51,7 +51,27 @@ particle::particle(int pid) {
 
 }
 
+particle::particle(int pid, particleStore* data, int index) {
+	//Set the initial parameters.
+	name = pid;
+
+	coorNumber = 0;
+
+	store = data;
+	slot = index;
+	ownsStore = false;
+	store->clear(slot);
+	store->id[slot] = pid;
+	cll = type3<int>(-1,-1,-1);
+
+	species = 0;
+	frozen = false;
+}
+
 particle::~particle() {
+	if (ownsStore) {
+		delete store;
+	}
 }
 
 /********************************************//**
@@ -59,34 +79,37 @@ particle::~particle() {
  ************************************************/
 
 void particle::setX(double val, double boxSize) {
-	double xTemp = pos.x;
+	double xTemp = store->x[slot];
 	//Update current position.
-	pos.x = PSim::util::safeMod(val, boxSize);
+	store->x[slot] = PSim::util::safeMod(val, boxSize);
 	//Set lat position.
-	pos0.x = PSim::util::safeMod0(xTemp, pos.x, boxSize);
-	if ((pos.x < 0.0) || (pos.x >= boxSize)){
+	store->x0[slot] = PSim::util::safeMod0(xTemp, store->x[slot], boxSize);
+	if ((store->x[slot] < 0.0) || (store->x[slot] >= boxSize)){
+		type3<double> pos = type3<double>(getX(), getY(), getZ());
 		PSim::error::throwParticleBoundsError(&pos, name);
 	}
 }
 
 void particle::setY(double val, double boxSize) {
-	double yTemp = pos.y;
+	double yTemp = store->y[slot];
 	//Update current position.
-	pos.y = PSim::util::safeMod(val, boxSize);
+	store->y[slot] = PSim::util::safeMod(val, boxSize);
 	//Set lat position.
-	pos0.y = PSim::util::safeMod0(yTemp, pos.y, boxSize);
-	if ((pos.y < 0.0) || (pos.y >= boxSize)) {
+	store->y0[slot] = PSim::util::safeMod0(yTemp, store->y[slot], boxSize);
+	if ((store->y[slot] < 0.0) || (store->y[slot] >= boxSize)) {
+		type3<double> pos = type3<double>(getX(), getY(), getZ());
 		PSim::error::throwParticleBoundsError(&pos, name);
 	}
 }
 
 void particle::setZ(double val, double boxSize) {
-	double zTemp = pos.z;
+	double zTemp = store->z[slot];
 	//Update current position.
-	pos.z = PSim::util::safeMod(val, boxSize);
+	store->z[slot] = PSim::util::safeMod(val, boxSize);
 	//Set lat position.
-	pos0.z = PSim::util::safeMod0(zTemp, pos.z, boxSize);
-	if ((pos.z < 0.0) || (pos.z >= boxSize)) {
+	store->z0[slot] = PSim::util::safeMod0(zTemp, store->z[slot], boxSize);
+	if ((store->z[slot] < 0.0) || (store->z[slot] >= boxSize)) {
+		type3<double> pos = type3<double>(getX(), getY(), getZ());
 		PSim::error::throwParticleBoundsError(&pos, name);
 	}
 }
@@ -107,12 +130,13 @@ void particle::updateForce(type3<double>* pos,
 	}
 
 	//Increment the existing value of force.
-	frc.x += pos->x;
-	frc.y += pos->y;
-	frc.z += pos->z;
+	double* frc = &(store->force[3*slot]);
+	frc[0] += pos->x;
+	frc[1] += pos->y;
+	frc[2] += pos->z;
 }
 
-void particle::setForce(double* val) {
+void particle::clearInteractions() {
 	//Reset interacting particles.
 	interactions.clear();
 	interactions.shrink_to_fit();
@@ -120,28 +144,34 @@ void particle::setForce(double* val) {
 	interactions.reserve(coorNumber);
 	//Reset coordination number;
 	coorNumber = 0;
+}
+
+void particle::setForce(double* val) {
+	clearInteractions();
 
-	frc0.x = frc.x;
-	frc0.y = frc.y;
-	frc0.z = frc.z;
+	double* frc = &(store->force[3*slot]);
+	double* frc0 = &(store->force0[3*slot]);
+	frc0[0] = frc[0];
+	frc0[1] = frc[1];
+	frc0[2] = frc[2];
 
-	frc.x = *(val);
-	frc.y = *(val+1);
-	frc.z = *(val+2);
+	frc[0] = *(val);
+	frc[1] = *(val+1);
+	frc[2] = *(val+2);
 }
 
 float particle::calculatePotential() {
-	float dx = pos.x-pos0.x;
-	float dy = pos.y-pos0.y;
-	float dz = pos.z-pos0.z;
+	float dx = getX()-getX0();
+	float dy = getY()-getY0();
+	float dz = getZ()-getZ0();
 
-    float dfx = frc.x - frc0.x;
-    float dfy = frc.y - frc0.y;
-    float dfz = frc.z - frc0.z;
+    float dfx = getFX() - getFX0();
+    float dfy = getFY() - getFY0();
+    float dfz = getFZ() - getFZ0();
 
     float dr = sqrt(dx*dx + dy*dy + dz*dz);
     float df = sqrt(dfx*dfx + dfy*dfy + dfz*dfz);
-    float f0 = sqrt(frc0.x*frc0.x + frc0.y*frc0.y + frc0.z*frc0.z);
+    float f0 = sqrt(getFX0()*getFX0() + getFY0()*getFY0() + getFZ0()*getFZ0());
 
     float p = (f0*dr) + (0.5*df*dr);
 
@@ -149,21 +179,16 @@ float particle::calculatePotential() {
 }
 
 void particle::nextIter() {
-
-	//Reset interacting particles.
-	interactions.clear();
-	interactions.shrink_to_fit();
-	//Minimize memory allocations by making a guess at how many slots we need.
-	interactions.reserve(coorNumber);
-	//Reset coordination number;
-	coorNumber = 0;
+	clearInteractions();
 
 	//Set the old force before clearing the current force.
-	frc0.x = frc.x;
-	frc0.y = frc.y;
-	frc0.z = frc.z;
-	frc.x = 0.0;
-	frc.y = 0.0;
-	frc.z = 0.0;
+	double* frc = &(store->force[3*slot]);
+	double* frc0 = &(store->force0[3*slot]);
+	frc0[0] = frc[0];
+	frc0[1] = frc[1];
+	frc0[2] = frc[2];
+	frc[0] = 0.0;
+	frc[1] = 0.0;
+	frc[2] = 0.0;
 }
 }
@@ -0,0 +1,124 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "particleStore.h"
+#include "numa.h"
+#include <cstdlib>
+#include <new>
+
+namespace PSim {
+
+particleStore::particleStore(int n, const char* component) {
+	capacity = n;
+
+	//Pad each array to a whole number of cache lines.
+	const int line = 8;
+	//Offsets past the first array can exceed an int for large systems.
+	size_t stride = (((size_t) n + line - 1) / line) * line;
+	stride = (stride < line) ? line : stride;
+
+	//Eleven per particle arrays and two interleaved force arrays.
+	size_t total = (11 * stride) + (2 * 3 * stride);
+	block = (double*) numa::reserve(total * sizeof(double), component);
+
+	double** arrays[11] = {&x, &y, &z, &x0, &y0, &z0, &vx, &vy, &vz, &radius, &mass};
+	for (int a = 0; a < 11; a++) {
+		*(arrays[a]) = block + (a * stride);
+		numa::touch(*(arrays[a]), stride);
+	}
+	force = block + (11 * stride);
+	force0 = force + (3 * stride);
+	numa::touch(force, 3 * stride);
+	numa::touch(force0, 3 * stride);
+
+	id = numa::allocate<int>(stride, component);
+	for (int i = 0; i < n; i++) {
+		id[i] = i;
+	}
+}
+
+particleStore::~particleStore() {
+	numa::release(block);
+	numa::release(id);
+}
+
+void particleStore::permute(const int* order, double* scratch) {
+#pragma omp parallel
+	permuteInTeam(order, scratch);
+}
+
+void particleStore::permuteInTeam(const int* order, double* scratch) {
+	int n = capacity;
+
+	//The scratch is shared, so each gather finishes before the copy back.
+	double* arrays[11] = {x, y, z, x0, y0, z0, vx, vy, vz, radius, mass};
+	for (int a = 0; a < 11; a++) {
+		double* arr = arrays[a];
+#pragma omp for
+		for (int k = 0; k < n; k++) {
+			scratch[k] = arr[order[k]];
+		}
+#pragma omp for
+		for (int k = 0; k < n; k++) {
+			arr[k] = scratch[k];
+		}
+	}
+
+	double* forces[2] = {force, force0};
+	for (int a = 0; a < 2; a++) {
+		double* arr = forces[a];
+#pragma omp for
+		for (int k = 0; k < n; k++) {
+			scratch[3*k] = arr[3*order[k]];
+			scratch[3*k+1] = arr[3*order[k]+1];
+			scratch[3*k+2] = arr[3*order[k]+2];
+		}
+#pragma omp for
+		for (int k = 0; k < 3*n; k++) {
+			arr[k] = scratch[k];
+		}
+	}
+
+	int* ids = (int*) scratch;
+#pragma omp for
+	for (int k = 0; k < n; k++) {
+		ids[k] = id[order[k]];
+	}
+#pragma omp for
+	for (int k = 0; k < n; k++) {
+		id[k] = ids[k];
+	}
+}
+
+void particleStore::clear(int i) {
+	double* arrays[11] = {x, y, z, x0, y0, z0, vx, vy, vz, radius, mass};
+	for (int a = 0; a < 11; a++) {
+		arrays[a][i] = 0.0;
+	}
+	for (int d = 0; d < 3; d++) {
+		force[3*i+d] = 0.0;
+		force0[3*i+d] = 0.0;
+	}
+}
+
+}
@@ -40,10 +40,7 @@ AnalysisSystem::AnalysisSystem(config* cfg,
 	createRewindDir();
 
 	// We need to rebuild the interactions table.
-	hashParticles();
-	sortParticles();
-	clearCells();
-	reorderParticles();
+	initCells();
 	updateInteractions();
 }
 
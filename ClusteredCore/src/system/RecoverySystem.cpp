@@ -32,6 +32,8 @@ RecoverySystem::RecoverySystem(config* cfg, std::string sysState,
 	int nParts = particlesInFile(sysState, timeStamp);
 	// Load in the particles.
 	int count = readParticles(sysState, timeStamp);
+	// Rebuild the cells for the loaded particles.
+	initCells();
 
 	// Maybe this should throw an error for count != nParts?
 	chatterBox.consoleMessage("Found " + tos(count) + " / " + tos(nParts) + " particles", 1);
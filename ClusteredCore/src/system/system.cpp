@@ -28,20 +28,33 @@ void system::setSystemConstants(config* cfg,
 		PSim::IIntegrator* sysInt, PSim::defaultForceManager* sysFcs) {
 
 	state = systemState();
+	//Memory is counted against the tracker of the thread that builds the system.
+	memory = memoryTracker::owner();
 
 	//Set time information
 	state.currentTime = 0;
 	state.dTime = cfg->getParam<double>("timeStep", 0.001);
+	//Set by run. Zero until then.
+	cycleHour = 0;
 	//Set the random number generator seed.
 	state.seed = cfg->getParam<int>("seed", 90210);
 	//Sets the system temperature.
 	state.temp = cfg->getParam<double>("kT", 1.0);
 	//Set the number of particles.
 	state.nParticles = cfg->getParam<int>("nParticles", 1000);
+	//Set the number of particle species.
+	state.nSpecies = cfg->getParam<int>("nSpecies", 1);
+	state.nSpecies = (state.nSpecies < 1) ? 1 : state.nSpecies;
 	//How often to output snapshots.
 	state.outputFreq = cfg->getParam<int>("outputFreq", int(1.0 / state.dTime));
 	//Set initial seed size;
 	seedSize = cfg->getParam<int>("seedSize", 0);
+	//Every seed particle takes a slot, so the cube must fit the system.
+	if (seedSize > 0 && (long) seedSize * seedSize * seedSize > state.nParticles) {
+		PSim::error::throwSeedSizeError(seedSize, state.nParticles);
+	}
+	//Hold the seed in place.
+	freezeSeed = cfg->getParam<int>("freezeSeed", 0);
 	//Set the integration method.
 	integrator = sysInt;
 	//Set the internal forces.
@@ -53,8 +66,16 @@ void system::setSystemConstants(config* cfg,
 	scale = cfg->getParam<int>("scale", 4);
 	//Set the radius.
 	double r = cfg->getParam<double>("radius", 0.5);
+	//Set the mass.
+	double m = cfg->getParam<double>("mass", 1.0);
+	//Split the particles into species.
+	initSpecies(cfg, r, m);
 	//Create a box based on desired concentration.
-	double vP = state.nParticles * (4.0 / 3.0) * atan(1.0) * 4.0 * r * r * r;
+	double vP = 0.0;
+	for (int s = 0; s < state.nSpecies; s++) {
+		double rs = speciesRadius[s];
+		vP += speciesCount[s] * (4.0 / 3.0) * atan(1.0) * 4.0 * rs * rs * rs;
+	}
 	state.boxSize = (int) (cbrt(vP / conc));
 	//Calculates the number of cells needed.
 	state.cellSize = state.boxSize / scale;
@@ -62,8 +83,17 @@ void system::setSystemConstants(config* cfg,
 	state.cellScale = scale;
 	//Sets the actual concentration.
 	state.concentration = vP / pow(state.boxSize, 3.0);
+	//Set up the time step controller.
+	initStepControl(cfg);
+	//How often the particle storage is put back in cell order.
+	reorderFreq = cfg->getParam<int>("reorderFreq", 100);
+	//Set if autotune runs.
+	tunedThreads = 0;
+	tunedBlocks = 0;
 
-	analysis = new PSim::analysisManager(trialName, &state);
+	//Snapshots are written on a thread of their own unless this is 0.
+	bool asyncOutput = (cfg->getParam<int>("asyncOutput", 1) != 0);
+	analysis = new PSim::analysisManager(trialName, &state, asyncOutput);
 }
 
 system::system(config* cfg, PSim::IIntegrator* sysInt,
@@ -93,16 +123,62 @@ system::system(config* cfg, PSim::IIntegrator* sysInt,
 	//Create particles.
 	initParticles(r, m);
 	//Create cells.
+	sortedParticles = NULL;
+	initCells();
+	if (cfg->getParam<int>("autotune", 0)) {
+		autotune(cfg);
+	}
+	int numCells = pow(state.cellScale, 3.0);
+	chatterBox.consoleMessage("Created: " + tos(numCells) + " cells from scale: " + tos(state.cellScale));
+	writeSystemInit();
+}
+
+void system::initCells() {
+	//Frozen particles are kept out of the per step rebuild.
+	mobileParticles.clear();
+	state.nFrozen = 0;
+	for (int i = 0; i < state.nParticles; i++) {
+		if (particles[i]->isFrozen()) {
+			state.nFrozen++;
+		} else {
+			mobileParticles.push_back(i);
+		}
+	}
+	if (state.nFrozen > 0) {
+		chatterBox.consoleMessage("Frozen particles: " + tos(state.nFrozen), 3);
+	}
+
+	//Each cell holds one run per species, and a second set if any particles are frozen.
 	int numCells = pow(state.cellScale, 3.0);
+	int blocks = (state.nFrozen > 0) ? 2 : 1;
 	particleHashIndex = vector<tuple<int,int>>(state.nParticles, tuple<int,int>());
-	cellStartEnd = vector<tuple<int,int>>(numCells, tuple<int,int>(0xffffffff, 0xffffffff));
-	sortedParticles = new double[4*state.nParticles];
-	particleForce  = new double[3*state.nParticles];
+	sortSpace = vector<tuple<int,int>>(state.nParticles, tuple<int,int>());
+	cellStartEnd = vector<tuple<int,int>>(numCells * state.nSpecies * blocks, tuple<int,int>(emptyCell, emptyCell));
+
+	numa::release(sortedParticles);
+	sortedParticles = numa::allocate<double>(4*state.nParticles, "cells");
+
+	//Storage order matches id order until the first reorder.
+	particlesById.assign(particles, particles + state.nParticles);
+
+	//Radius and species never change, so the bins hold them from the start.
+	bins.pos.assign(4*state.nParticles, 0.0);
+	bins.key.assign(state.nParticles, 0);
+	bins.species.assign(state.nParticles, 0);
+	for (int i = 0; i < state.nParticles; i++) {
+		bins.pos[4*i+3] = particles[i]->getRadius();
+		bins.species[i] = particles[i]->getSpecies();
+	}
+	bins.cellSize = state.cellSize;
+	bins.cellScale = state.cellScale;
+	bins.nSpecies = state.nSpecies;
+	bins.filled = false;
+	state.bins = &bins;
+
+	freezeCells();
 	hashParticles();
 	sortParticles();
 	reorderParticles();
-	chatterBox.consoleMessage("Created: " + tos(numCells) + " cells from scale: " + tos(state.cellScale));
-	writeSystemInit();
 }
 
 void system::writeSystemInit() {
@@ -117,6 +193,7 @@ void system::writeSystemInit() {
 #endif
 	myFile << "trialName = " << trialName << "\n";
 	myFile << "nParticles = " << state.nParticles << "\n";
+	myFile << "nSpecies = " << state.nSpecies << "\n";
 	myFile << "Concentration = " << state.concentration << "\n";
 	myFile << "boxSize = " << state.boxSize << "\n";
 	myFile << "cellSize = " << state.cellSize << "\n";
@@ -125,12 +202,16 @@ void system::writeSystemInit() {
 	myFile << "dTime = " << state.dTime << "\n";
 	myFile << "outputFreq = " << state.outputFreq << "\n";
 	myFile << "cycleHour = " << cycleHour << "\n";
+	if (tunedThreads > 0) {
+		myFile << "ompThreads = " << tunedThreads << "\n";
+		myFile << "blocksPerThread = " << tunedBlocks << "\n";
+	}
 	myFile << "seed = " << state.seed;
 
 	//Close the stream.
 	myFile.close();
 
-	analysis->writeInitialState(particles, &state);
+	analysis->writeInitialState(particlesById.data(), &state);
 
 	ifstream inCfg("settings.cfg", ios::binary);
 	ofstream outCfg(trialName + "/settings.cfg", ios::binary);
@@ -141,32 +222,74 @@ void system::writeSystemInit() {
 
 system::~system() {
 	//Deletes the particles
+	//The pool frees the memory. Only the destructors are run here.
 	for (int i = 0; i < state.nParticles; i++) {
-		delete particles[i];
+		particleSlots[i].~particle();
 	}
-	delete[] particles;
-	delete[] particleForce;
-	delete[] sortedParticles;
+	delete store;
+	numa::release(sortedParticles);
 
 	delete integrator;
 	delete sysForces;
+	//Waits for the last snapshot.
+	delete analysis;
 }
 
 void system::estimateCompletion(PSim::timer* tmr) {
-	int cycleCount = (state.currentTime/state.dTime);
 	if ((cycleCount % state.outputFreq) == 0 && cycleCount > 0) {
 		tmr->stop();
 		double timePerCycle = tmr->getElapsedSeconds() / double(state.outputFreq);
 		std::setprecision(4);
 		chatterBox.consoleMessage("Average Cycle Time: " + tos(timePerCycle));
-		double totalTime = (cycleHour * timePerCycle);
-		double finishedTime = ((state.currentTime / state.dTime) / 3600) * timePerCycle;
-		double dif = totalTime - finishedTime;
+		//Extrapolate by simulated time, so a changing time step is accounted for.
+		double timePerUnit = tmr->getElapsedSeconds() / (state.currentTime - lastEstimate);
+		double dif = ((state.endTime - state.currentTime) * timePerUnit) / 3600;
 		chatterBox.consoleMessage("Time until completion: " + tos(dif) + " hours.");
+		trackMemory();
+		chatterBox.consoleMessage("Memory: " + tos(memory->total() / 1e6) + " MB. Peak: " + tos(memory->peakTotal() / 1e6) + " MB.");
+		memory->write(trialName + "/memoryGraph.txt", state.currentTime);
+		sysForces->reportBalance();
+		lastEstimate = state.currentTime;
 		tmr->start();
 	}
 }
 
+void system::trackMemory() {
+	size_t table = (cellStartEnd.capacity() + particleHashIndex.capacity() + sortSpace.capacity()) * sizeof(tuple<int,int>);
+	table += bins.pos.capacity() * sizeof(double);
+	table += (bins.key.capacity() + bins.species.capacity() + mobileParticles.capacity()) * sizeof(int);
+	table += particlesById.capacity() * sizeof(particle*);
+	memory->set("cellTable", table);
+	memory->set("stepControl", savedParticles.capacity() * sizeof(double));
+
+	size_t links = 0;
+	for (int i = 0; i < state.nParticles; i++) {
+		links += particles[i]->getInteractions().capacity() * sizeof(particle*);
+	}
+	memory->set("interactions", links);
+}
+
+void system::stepInTeam() {
+	sysForces->getAccelerationInTeam(sortedParticles, store->force0, &particleHashIndex, &cellStartEnd, &state);
+#ifdef WITHPOST
+	sysForces->getPostRoutineInTeam(sortedParticles, store->force0, &particleHashIndex, &cellStartEnd, &state);
+#endif
+	//A failed phase leaves nothing the next phase can use. Every thread sees the flag after the barrier.
+	if (sysForces->failure.raised()) {
+		return;
+	}
+	pushParticleForceInTeam();
+	integrator->nextSystemInTeam(particles, &state);
+	if (integrator->failure.raised()) {
+		return;
+	}
+	rebuildCellsInTeam();
+	if ((reorderFreq > 0) && ((cycleCount + 1) % reorderFreq == 0)) {
+		permuteParticlesInTeam();
+	}
+	updateInteractionsInTeam();
+}
+
 void system::run(double endTime) {
 	state.endTime = endTime;
 	cycleHour = (state.endTime / state.dTime) / 3600.0;
@@ -178,37 +301,77 @@ void system::run(double endTime) {
 	std::string mov = trialName + "/movie";
 	mkdir(mov.c_str(), 0777);
 
+	//Memory of each part of the engine at the start.
+	trackMemory();
+	memory->report();
+	memory->write(trialName + "/memoryGraph.txt", state.currentTime);
+
 	//Diagnostics timer.
 	PSim::timer* tmr = new PSim::timer();
 	tmr->start();
 
 	chatterBox.resetChatterCount();
+	cycleCount = 0;
+	lastEstimate = state.currentTime;
 	//Run system until end time.
+	//The fixed step runs in one team when the integrator can join it.
+	bool inTeam = !adaptiveStep && integrator->runsInTeam();
 	while (state.currentTime < state.endTime) {
-		//Get the forces acting on the system.
-		sysForces->getAcceleration(sortedParticles, particleForce, &particleHashIndex, &cellStartEnd, &state);
+		stepScratch.reset();
+		if (inTeam) {
+			//Global force terms open their own regions, so they run before the team.
+			sysForces->prepareAcceleration(sortedParticles, store->force0, &particleHashIndex, &cellStartEnd, &state);
+#pragma omp parallel
+			stepInTeam();
+			//Errors caught by the team are raised once it has closed.
+			sysForces->failure.rethrow();
+			integrator->failure.rethrow();
+		} else {
+			//Get the forces acting on the system.
+			//Forces are written over the previous forces, which the last step has finished with.
+			sysForces->getAcceleration(sortedParticles, store->force0, &particleHashIndex, &cellStartEnd, &state);
 #ifdef WITHPOST
-		sysForces->getPostRoutine(sortedParticles, particleForce, &particleHashIndex, &cellStartEnd, &state);
+			sysForces->getPostRoutine(sortedParticles, store->force0, &particleHashIndex, &cellStartEnd, &state);
 #endif
-		// Update the particle system
-		pushParticleForce();
-		//Get the next system.
-		integrator->nextSystem(particles, &state);
-		// Rebuild the hash table
-		hashParticles();
-		sortParticles();
-		clearCells();
-		reorderParticles();
-		// Get new particle interactions
-		updateInteractions();
+			// Update the particle system
+			pushParticleForce();
+			if (adaptiveStep) {
+				//Step, check and retry at a smaller time step if needed.
+				adaptiveTimeStep();
+			} else {
+				//Get the next system.
+				integrator->nextSystem(particles, &state);
+				// Rebuild the hash table
+				rebuildCells();
+			}
+			//Keep the storage in cell order as the particles move.
+			if ((reorderFreq > 0) && ((cycleCount + 1) % reorderFreq == 0)) {
+				permuteParticles();
+			}
+			// Get new particle interactions
+			updateInteractions();
+		}
 		//runAnalysis;
-		analysis->writeRunTimeState(particles, &state);
+		analysis->writeRunTimeState(particlesById.data(), &state);
 		estimateCompletion(tmr);
 		//Update loading bar.
 		PSim::util::loadBar(state.currentTime, state.endTime);
 		//Increment counters.
 		state.currentTime += state.dTime;
+		cycleCount++;
+	}
+
+	if (adaptiveStep) {
+		//The loop writes a snapshot time on the step that leaves it, so only an end time
+		//that the last step was trimmed to land on still needs writing.
+		if (fabs(nextSnapshot - state.currentTime) <= 1e-9 * state.outputInterval) {
+			analysis->writeRunTimeState(particlesById.data(), &state);
+		}
+		chatterBox.consoleMessage("Adaptive steps taken: " + tos(cycleCount) + " Rejected: " + tos(rejectedSteps), 1);
+		chatterBox.consoleMessage("Final time step: " + tos(dtTarget), 1);
 	}
+	//The last snapshot may still be on the writer thread.
+	analysis->flush();
 }
 }
 
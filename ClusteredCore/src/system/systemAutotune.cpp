@@ -0,0 +1,143 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "system.h"
+#include "pairTable.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace PSim {
+
+/********************************************//**
+ *--------------------AUTOTUNE--------------------
+ ************************************************/
+
+double system::timeForcePass(int passes) {
+	//One untimed pass grows the tiles and the scheduler queues.
+	rebuildCells();
+	sysForces->getAcceleration(sortedParticles, store->force0, &particleHashIndex, &cellStartEnd, &state);
+
+	double start = omp_get_wtime();
+	for (int p = 0; p < passes; p++) {
+		rebuildCells();
+		sysForces->getAcceleration(sortedParticles, store->force0, &particleHashIndex, &cellStartEnd, &state);
+	}
+	return (omp_get_wtime() - start) / passes;
+}
+
+void system::setCellScale(int scale) {
+	if (scale == state.cellScale) {
+		return;
+	}
+	state.cellScale = scale;
+	state.cellSize = state.boxSize / scale;
+	initCells();
+}
+
+void system::autotune(config* cfg) {
+	int passes = cfg->getParam<int>("autotuneSteps", 20);
+	passes = (passes < 1) ? 1 : passes;
+	int team = omp_get_max_threads();
+	int blocks = cfg->getParam<int>("blocksPerThread", 8);
+
+	//A cell may not be narrower than the longest cutoff. Without one only coarser grids are tried.
+	pairTable cutOff = pairTable(cfg, "cutOff", state.cellSize, state.nSpecies);
+	double minCell = 0;
+	for (int i = 0; i < state.nSpecies; i++) {
+		for (int j = 0; j < state.nSpecies; j++) {
+			minCell = std::max(minCell, cutOff(i, j));
+		}
+	}
+	minCell = cfg->getParam<double>("autotuneMinCell", minCell);
+
+	//The box is fixed, so the scale must divide it. The neighbor walk needs three cells a side.
+	//Grids with more cells than particles only add empty cells.
+	vector<int> scales(1, state.cellScale);
+	double maxCells = std::max((double) state.nParticles, pow(state.cellScale, 3.0));
+	for (int s = 3; s <= state.boxSize; s++) {
+		if ((state.boxSize % s != 0) || (state.boxSize / s < minCell) || (pow(s, 3.0) > maxCells) || (s == state.cellScale)) {
+			continue;
+		}
+		scales.push_back(s);
+	}
+
+	//The team may shrink but not grow, since pinning only covers the configured team.
+	vector<int> teams(1, team);
+	for (int t = 1; t < team; t *= 2) {
+		teams.push_back(t);
+	}
+	vector<int> blockCounts(1, blocks);
+	for (int b = 2; b <= 32; b *= 2) {
+		if (b != blocks) {
+			blockCounts.push_back(b);
+		}
+	}
+
+	//The configured value is tried first and only replaced by a clear win over timer noise.
+	const double margin = 0.98;
+	chatterBox.consoleMessage("Autotune: " + tos(passes) + " passes per candidate", 1);
+
+	//Cell grid with the full team first. It sets the pair work the team then splits.
+	int bestScale = state.cellScale;
+	double best = 0;
+	for (unsigned int k = 0; k < scales.size(); k++) {
+		setCellScale(scales[k]);
+		double t = timeForcePass(passes);
+		chatterBox.consoleMessage("Scale " + tos(scales[k]) + ": " + tos(1000.0 * t) + " ms", 3);
+		if (k == 0 || t < margin * best) {
+			best = t;
+			bestScale = scales[k];
+		}
+	}
+	setCellScale(bestScale);
+
+	int bestTeam = team;
+	int bestBlocks = blocks;
+	best = 0;
+	for (unsigned int i = 0; i < teams.size(); i++) {
+		omp_set_num_threads(teams[i]);
+		for (unsigned int j = 0; j < blockCounts.size(); j++) {
+			sysForces->setBlocksPerThread(blockCounts[j]);
+			double t = timeForcePass(passes);
+			chatterBox.consoleMessage("Threads " + tos(teams[i]) + ", blocks " + tos(blockCounts[j]) + ": " + tos(1000.0 * t) + " ms", 3);
+			if ((i == 0 && j == 0) || t < margin * best) {
+				best = t;
+				bestTeam = teams[i];
+				bestBlocks = blockCounts[j];
+			}
+		}
+	}
+
+	omp_set_num_threads(bestTeam);
+	sysForces->setBlocksPerThread(bestBlocks);
+	tunedThreads = bestTeam;
+	tunedBlocks = bestBlocks;
+	//The cell tables are left built for the chosen grid.
+	rebuildCells();
+	sysForces->clearBalance();
+	chatterBox.consoleMessage("Autotune picked threads: " + tos(bestTeam) + ", blocks: " + tos(bestBlocks)
+			+ ", scale: " + tos(bestScale), 1);
+}
+
+}
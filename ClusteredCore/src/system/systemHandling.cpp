@@ -21,6 +21,7 @@
  SOFTWARE.*/
 
 #include "system.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -30,38 +31,122 @@ namespace PSim {
  *---------------PARTICLE HANDLING----------------
  ************************************************/
 
-void system::hashParticles() {
-	int cellScaleSq = state.cellScale * state.cellScale;
-#pragma omp parallel for
-	for (int i = 0; i < state.nParticles; i++) {
-		type3<int> itemCell;
+int system::cellHash(int i) {
+	type3<int> itemCell;
 
-		itemCell.x = floor(particles[i]->getX() / state.cellSize);
-		itemCell.y = floor(particles[i]->getY() / state.cellSize);
-		itemCell.z = floor(particles[i]->getZ() / state.cellSize);
+	itemCell.x = floor(store->x[i] / state.cellSize);
+	itemCell.y = floor(store->y[i] / state.cellSize);
+	itemCell.z = floor(store->z[i] / state.cellSize);
+
+	return itemCell.x + (state.cellScale * itemCell.y) + (state.cellScale * state.cellScale * itemCell.z);
+}
+
+void system::hashParticles() {
+#pragma omp parallel
+	hashParticlesInTeam();
+}
 
-		int hash = itemCell.x + (state.cellScale * itemCell.y) + (cellScaleSq * itemCell.z);
+void system::hashParticlesInTeam() {
+	int nMobile = state.nParticles - state.nFrozen;
+	//The integrator already hashed every particle it moved.
+	if (bins.filled) {
+		const int* key = bins.key.data();
+#pragma omp for
+		for (int k = 0; k < nMobile; k++) {
+			int i = mobileParticles[k];
+			get<0>(particleHashIndex[k]) = key[i];
+			get<1>(particleHashIndex[k]) = i;
+		}
+		return;
+	}
+#pragma omp for
+	for (int k = 0; k < nMobile; k++) {
+		int i = mobileParticles[k];
 
-		get<0>(particleHashIndex[i]) = hash;
-		get<1>(particleHashIndex[i]) = i;
+		//Sort by species within each cell.
+		get<0>(particleHashIndex[k]) = (cellHash(i) * state.nSpecies) + particles[i]->getSpecies();
+		get<1>(particleHashIndex[k]) = i;
 	}
 }
 
 void system::sortParticles() {
-	__gnu_parallel::sort(particleHashIndex.begin(), particleHashIndex.end(), util::sortParticleTuple);
+#pragma omp parallel
+	sortParticlesInTeam();
 }
 
-void system::reorderParticles() {
-#pragma omp parallel for
+void system::sortParticlesInTeam() {
+	int nMobile = state.nParticles - state.nFrozen;
+	int team = omp_get_num_threads();
+	int t = omp_get_thread_num();
+	auto slice = [nMobile, team](int s) {
+		return (int) (((long) nMobile * s) / team);
+	};
+
+	//Ties are broken by particle, so the order is the same however the table is cut.
+	tuple<int,int>* from = particleHashIndex.data();
+	tuple<int,int>* to = sortSpace.data();
+	std::sort(from + slice(t), from + slice(t + 1));
+
+	//Merge neighboring slices in pairs until one is left.
+	for (int width = 1; width < team; width *= 2) {
+#pragma omp barrier
+		if (t % (2 * width) == 0) {
+			int first = slice(t);
+			int mid = slice(std::min(t + width, team));
+			int last = slice(std::min(t + (2 * width), team));
+			std::merge(from + first, from + mid, from + mid, from + last, to + first);
+		}
+		std::swap(from, to);
+	}
+
+#pragma omp barrier
+	//An odd number of rounds leaves the table in the merge buffer.
+	if (from != particleHashIndex.data()) {
+#pragma omp for
+		for (int k = 0; k < nMobile; k++) {
+			particleHashIndex[k] = sortSpace[k];
+		}
+	}
+}
+
+void system::freezeCells() {
+	int nMobile = state.nParticles - state.nFrozen;
+	//Frozen runs start after every mobile run.
+	int offset = state.cellScale * state.cellScale * state.cellScale * state.nSpecies;
+
+	int k = nMobile;
 	for (int i = 0; i < state.nParticles; i++) {
+		if (particles[i]->isFrozen()) {
+			get<0>(particleHashIndex[k]) = offset + (cellHash(i) * state.nSpecies) + particles[i]->getSpecies();
+			get<1>(particleHashIndex[k]) = i;
+			k++;
+		}
+	}
+
+	std::sort(particleHashIndex.begin() + nMobile, particleHashIndex.end(), util::sortParticleTuple);
+	linkCells(nMobile, state.nParticles);
+}
+
+void system::reorderParticles() {
+	linkCells(0, state.nParticles - state.nFrozen);
+}
+
+void system::linkCells(int first, int last) {
+#pragma omp parallel
+	linkCellsInTeam(first, last);
+}
+
+void system::linkCellsInTeam(int first, int last) {
+#pragma omp for
+	for (int i = first; i < last; i++) {
 		// Set Cell Data.
 		int currentHash = get<0>(particleHashIndex[i]);
 
-		if (i == 0) {
-			get<0>(cellStartEnd[currentHash]) = 0;
+		if (i == first) {
+			get<0>(cellStartEnd[currentHash]) = first;
 		}
 
-		if (i > 0) {
+		if (i > first) {
 			int prevHash = get<0>(particleHashIndex[i-1]);
 
 			if (prevHash != currentHash) {
@@ -70,51 +155,136 @@ void system::reorderParticles() {
 			}
 		}
 
-		if (i == state.nParticles - 1) {
-			get<1>(cellStartEnd[currentHash]) = state.nParticles;
+		if (i == last - 1) {
+			get<1>(cellStartEnd[currentHash]) = last;
 		}
 
 		// Copy Particle Data.
 		int index = get<1>(particleHashIndex[i]);
 		int offset = 4*i;
-		sortedParticles[offset] = particles[index]->getX();
-		sortedParticles[offset+1] = particles[index]->getY();
-		sortedParticles[offset+2] = particles[index]->getZ();
-		sortedParticles[offset+3] = particles[index]->getRadius();
+		if (bins.filled) {
+			const double* binned = &(bins.pos[4*index]);
+			sortedParticles[offset] = binned[0];
+			sortedParticles[offset+1] = binned[1];
+			sortedParticles[offset+2] = binned[2];
+			sortedParticles[offset+3] = binned[3];
+		} else {
+			sortedParticles[offset] = store->x[index];
+			sortedParticles[offset+1] = store->y[index];
+			sortedParticles[offset+2] = store->z[index];
+			sortedParticles[offset+3] = store->radius[index];
+		}
 	}
 }
 
-void system::pushParticleForce() {
-#pragma omp parallel for
-	for (int i =0; i < state.nParticles; i++) {
-		particles[i]->setForce(&(particleForce[3*i]));
+void system::permuteParticlesInTeam() {
+	int n = state.nParticles;
+
+#pragma omp single
+	{
+		//The noise producer reads the ids, so it must finish before they move.
+		if (integrator != NULL) {
+			integrator->beginReorder();
+		}
+		permuteOrder = stepScratch.allocate<int>(n);
+		permuteSpace = stepScratch.allocate<double>((size_t) 3 * n);
+		permuteMoved = stepScratch.allocate<particle*>(n);
+		permuteSpecies = stepScratch.allocate<int>(n);
+	}
+	int* order = permuteOrder;
+	particle** moved = permuteMoved;
+	int* species = permuteSpecies;
+
+	//The hash table lists mobile particles by cell, then frozen particles by cell.
+#pragma omp for
+	for (int k = 0; k < n; k++) {
+		order[k] = get<1>(particleHashIndex[k]);
+		moved[k] = particles[k];
+		species[k] = bins.species[k];
 	}
-}
 
-void system::iterateParticleInteractions(int index, int hash) {
-	int start = get<0>(cellStartEnd[hash]);
+	store->permuteInTeam(order, permuteSpace);
+
+#pragma omp for
+	for (int k = 0; k < n; k++) {
+		particles[k] = moved[order[k]];
+		particles[k]->setSlot(k);
+		bins.species[k] = species[order[k]];
+		bins.pos[4*k+3] = store->radius[k];
+		//The table now points at the new slots. sortedParticles is already in this order.
+		get<1>(particleHashIndex[k]) = k;
+	}
+
+	//Mobile particles now fill the front of the storage.
+	int nMobile = n - state.nFrozen;
+#pragma omp for
+	for (int k = 0; k < nMobile; k++) {
+		mobileParticles[k] = k;
+	}
 
-	type3<double> cellForce = type3<double>();
+	if (integrator != NULL) {
+		integrator->reorderInTeam(order, n);
+	}
+}
 
-	if (start != 0xffffffff) {
-		int end = get<1>(cellStartEnd[hash]);
-		for (int i=start; i<end; i++) {
-			if (i != index) {
-				int indexOffset = 4*index;
-				int iOffset = 4*i;
+void system::pushParticleForce() {
+#pragma omp parallel
+	pushParticleForceInTeam();
+}
 
-				double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
-																	sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
-																	state.boxSize);
+void system::pushParticleForceInTeam() {
+	//The new forces were written in place, so only the buffers move.
+	//One thread swaps them while the rest start on the interaction lists.
+#pragma omp single nowait
+	store->swapForces();
+#pragma omp for
+	for (int i =0; i < state.nParticles; i++) {
+		particles[i]->clearInteractions();
+	}
+}
 
+void system::rebuildCellsInTeam() {
+	int nMobile = state.nParticles - state.nFrozen;
+	int mobileRuns = state.cellScale * state.cellScale * state.cellScale * state.nSpecies;
+	hashParticlesInTeam();
+	//The sort only touches the hash table, so the mobile runs are cleared alongside it.
+#pragma omp for nowait
+	for (int r = 0; r < mobileRuns; r++) {
+		cellStartEnd[r] = tuple<int,int>(emptyCell, emptyCell);
+	}
+	sortParticlesInTeam();
+	linkCellsInTeam(0, nMobile);
+#pragma omp single nowait
+	bins.filled = false;
+}
 
-				double r = sqrt(rSquared);
-				//If the particles are in the potential well.
-				if (r < (1.2))
-				{
-					int realIndex = get<1>(particleHashIndex[index]);
-					int realI = get<1>(particleHashIndex[i]);
-					particles[realIndex]->addInteraction(particles[realI]);
+void system::iterateParticleInteractions(int index, int hash) {
+	//Each cell holds one run per species, and a second set for frozen particles.
+	int nRuns = state.runsPerCell();
+	for (int k = 0; k < nRuns; k++) {
+		int run = state.runIndex(hash, k);
+		int start = get<0>(cellStartEnd[run]);
+
+		if (start != emptyCell) {
+			int end = get<1>(cellStartEnd[run]);
+			for (int i=start; i<end; i++) {
+				if (i != index) {
+					int indexOffset = 4*index;
+					int iOffset = 4*i;
+
+					double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
+																		sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
+																		state.boxSize);
+
+
+					double r = sqrt(rSquared);
+					//If the particles are in the potential well.
+					if (r < (1.2))
+					{
+						int realIndex = get<1>(particleHashIndex[index]);
+						int realI = get<1>(particleHashIndex[i]);
+						particles[realIndex]->addInteraction(particles[realI]);
+					}
 				}
 			}
 		}
@@ -122,8 +292,13 @@ void system::iterateParticleInteractions(int index, int hash) {
 }
 
 void system::updateInteractions() {
+#pragma omp parallel
+	updateInteractionsInTeam();
+}
+
+void system::updateInteractionsInTeam() {
 	using namespace std;
-#pragma omp parallel for
+#pragma omp for nowait
 	for (int index=0; index < state.nParticles; index++) {
 		int hash = 0;
 		int indexOffset = index*4;
@@ -160,4 +335,5 @@ void system::updateInteractions() {
 	}
 }
 
+
 }
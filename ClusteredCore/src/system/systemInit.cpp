@@ -28,8 +28,60 @@ namespace PSim {
  *------------------SYSTEM INIT-------------------
  ************************************************/
 
+void system::initSpecies(config* cfg, double r, double m) {
+	int nSpecies = state.nSpecies;
+	speciesCount = std::vector<int>(nSpecies, 0);
+	speciesRadius = std::vector<double>(nSpecies, r);
+	speciesMass = std::vector<double>(nSpecies, m);
+	speciesFrozen = std::vector<bool>(nSpecies, false);
+
+	if (nSpecies == 1) {
+		speciesCount[0] = state.nParticles;
+		return;
+	}
+
+	//Species fractions default to an even split.
+	std::vector<double> fraction(nSpecies, 1.0);
+	double total = 0.0;
+	for (int s = 0; s < nSpecies; s++) {
+		fraction[s] = cfg->getParam<double>("speciesFraction_" + tos(s), 1.0);
+		speciesRadius[s] = cfg->getParam<double>("radius_" + tos(s), r);
+		speciesMass[s] = cfg->getParam<double>("mass_" + tos(s), m);
+		speciesFrozen[s] = cfg->getParam<int>("frozen_" + tos(s), 0);
+		total += fraction[s];
+	}
+
+	//The last species takes the rounding remainder.
+	int assigned = 0;
+	for (int s = 0; s < nSpecies - 1; s++) {
+		speciesCount[s] = int(floor(state.nParticles * fraction[s] / total));
+		assigned += speciesCount[s];
+	}
+	speciesCount[nSpecies - 1] = state.nParticles - assigned;
+
+	for (int s = 0; s < nSpecies; s++) {
+		chatterBox.consoleMessage("Species " + tos(s) + ": " + tos(speciesCount[s]) + " particles", 3);
+	}
+}
+
+int system::speciesOf(int i) {
+	//Species are laid out in contiguous blocks of the particle table.
+	int upper = 0;
+	for (int s = 0; s < state.nSpecies; s++) {
+		upper += speciesCount[s];
+		if (i < upper) {
+			return s;
+		}
+	}
+	return state.nSpecies - 1;
+}
+
 void system::initParticles(double r, double m) {
-	particles = new particle*[state.nParticles];
+	//The particle objects sit in one block rather than one allocation each.
+	particles = particlePool.allocate<particle*>(state.nParticles);
+	particleSlots = particlePool.allocate<particle>(state.nParticles);
+	store = new particleStore(state.nParticles);
+	state.store = store;
 
 	//If there is no inital seed create one.
 	if (state.seed == 0) {
@@ -60,12 +112,14 @@ void system::initParticles(double r, double m) {
 			for (int y = lowerSeed; y < upperSeed; y++) {
 				for (int z = lowerSeed; z < upperSeed; z++) {
 					float center = boxSize/2.0; // Center of the box
-					particles[seedCount] = new particle(seedCount);
+					particles[seedCount] = new (particleSlots + seedCount) particle(seedCount, store, seedCount);
 					particles[seedCount]->setX(center + (2.1*x*r), boxSize);
 					particles[seedCount]->setY(center + (2.1*y*r), boxSize);
 					particles[seedCount]->setZ(center + (2.1*z*r), boxSize);
-					particles[seedCount]->setRadius(r);
-					particles[seedCount]->setMass(m);
+					particles[seedCount]->setSpecies(speciesOf(seedCount));
+					particles[seedCount]->setRadius(speciesRadius[speciesOf(seedCount)]);
+					particles[seedCount]->setMass(speciesMass[speciesOf(seedCount)]);
+					particles[seedCount]->setFrozen(freezeSeed || speciesFrozen[speciesOf(seedCount)]);
 					seedCount++;
 				}
 			}
@@ -76,14 +130,17 @@ void system::initParticles(double r, double m) {
 
 	//Iterates through all points.
 	for (int i = seedCube; i < state.nParticles; i++) {
-		particles[i] = new particle(i);
+		particles[i] = new (particleSlots + i) particle(i, store, i);
 
 		particles[i]->setX(distribution(gen) * boxSize, boxSize);
 		particles[i]->setY(distribution(gen) * boxSize, boxSize);
 		particles[i]->setZ(distribution(gen) * boxSize, boxSize);
 
-		particles[i]->setRadius(r);
-		particles[i]->setMass(m);
+		int s = speciesOf(i);
+		particles[i]->setSpecies(s);
+		particles[i]->setRadius(speciesRadius[s]);
+		particles[i]->setMass(speciesMass[s]);
+		particles[i]->setFrozen(speciesFrozen[s]);
 
 	}
 
@@ -97,6 +154,17 @@ void system::initParticles(double r, double m) {
 	//Set initial velocity.
 	maxwellVelocityInit(&gen, &distribution);
 
+	//Frozen particles start at rest. Setting the position again clears the last position.
+	for (int i = 0; i < state.nParticles; i++) {
+		if (particles[i]->isFrozen()) {
+			type3<double> rest(particles[i]->getX(), particles[i]->getY(), particles[i]->getZ());
+			particles[i]->setPos(&rest, boxSize);
+			particles[i]->setVX(0.0);
+			particles[i]->setVY(0.0);
+			particles[i]->setVZ(0.0);
+		}
+	}
+
 	chatterBox.consoleMessage("Maxwell distribution created. Created cell assignment.", 3);
 }
 
@@ -50,30 +50,46 @@ int system::readParticles(std::string sysState,
 	// Read in each particle.
 	int count = 0;
 	for (std::string line; std::getline(streamState, line);) {
+		//The tables were built for nParticles.
+		if (count == state.nParticles) {
+			chatterBox.consoleMessage("More particles in the file than nParticles. The rest are skipped.", 1);
+			break;
+		}
 		istringstream data(line);
 
-		type3<double>* pos = new type3<double>();
-		type3<double>* pos0 = new type3<double>();
-		type3<double>* frc = new type3<double>();
-		type3<double>* frc0 = new type3<double>();
+		type3<double> pos, pos0, frc, frc0;
 
 		float m, r;
+		int s = 0;
+		int frozen = 0;
 
-		data >> pos->x >> pos->y >> pos->z;
-		data >> pos0->x >> pos0->y >> pos0->z;
-		data >> frc->x >> frc->y >> frc->z;
-		data >> frc0->x >> frc0->y >> frc0->z;
+		data >> pos.x >> pos.y >> pos.z;
+		data >> pos0.x >> pos0.y >> pos0.z;
+		data >> frc.x >> frc.y >> frc.z;
+		data >> frc0.x >> frc0.y >> frc0.z;
 		data >> m >> r;
+		//Single species files have no species column.
+		if (!(data >> s)) {
+			s = 0;
+		}
+		//Only systems with frozen particles have a frozen column.
+		if (!(data >> frozen)) {
+			frozen = 0;
+		}
 
 		// Set each particle to the oldest know position and advance to the newest known position.
-		particles[count] = new particle(count);
-		particles[count]->setPos(pos0, state.boxSize);
-		particles[count]->updateForce(frc0, NULL, false);
+		//The slot already holds the particle the system was built with.
+		particleSlots[count].~particle();
+		particles[count] = new (particleSlots + count) particle(count, store, count);
+		particles[count]->setPos(&pos0, state.boxSize);
+		particles[count]->updateForce(&frc0, NULL, false);
 		particles[count]->nextIter();
-		particles[count]->setPos(pos, state.boxSize);
-		particles[count]->updateForce(frc, NULL, false);
+		particles[count]->setPos(&pos, state.boxSize);
+		particles[count]->updateForce(&frc, NULL, false);
 		particles[count]->setMass(m);
 		particles[count]->setRadius(r);
+		particles[count]->setSpecies(s);
+		particles[count]->setFrozen(frozen != 0);
 
 		count++;
 	}
@@ -82,6 +98,7 @@ int system::readParticles(std::string sysState,
 
 void system::readSettings(config* cfg) {
 	cfg->showOutput();
+	state.nSpecies = cfg->getParam<int>("nSpecies", 1);
 	state.concentration = cfg->getParam<double>("Concentration", 0);
 	state.cellSize = cfg->getParam<int>("cellSize", 0);
 	state.cellScale = cfg->getParam<int>("cellScale", 0);
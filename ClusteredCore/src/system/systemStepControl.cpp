@@ -0,0 +1,291 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+#include "system.h"
+
+using namespace std;
+
+namespace PSim {
+
+//The force managers stop the run at 0.8 of contact.
+static const double overlapGap = 0.8;
+
+/********************************************//**
+ *--------------ADAPTIVE TIME STEP---------------
+ ************************************************/
+
+void system::initStepControl(config* cfg) {
+	adaptiveStep = cfg->getParam<int>("adaptiveStep", 0);
+	//Limits on the time step.
+	dtMin = cfg->getParam<double>("dtMin", state.dTime / 100.0);
+	dtMax = cfg->getParam<double>("dtMax", state.dTime * 4.0);
+	//The force managers stop the run at 0.8 of contact, so reject before that.
+	stepMinGap = cfg->getParam<double>("stepMinGap", 0.85);
+	stepSafeGap = cfg->getParam<double>("stepSafeGap", 0.9);
+	stepMaxDrift = cfg->getParam<double>("stepMaxDrift", 0.1);
+	stepMaxHeat = cfg->getParam<double>("stepMaxHeat", 0.2);
+	stepShrink = cfg->getParam<double>("stepShrink", 0.5);
+	stepGrow = cfg->getParam<double>("stepGrow", 1.2);
+	stepGrowAfter = cfg->getParam<int>("stepGrowAfter", 20);
+
+	dtTarget = state.dTime;
+	nextSnapshot = 0;
+	quietSteps = 0;
+	rejectedSteps = 0;
+	lastGap = -1;
+	lastHeat = 0;
+	hotSteps = 0;
+	hotHeat = 0;
+	cycleCount = 0;
+	lastEstimate = 0;
+	state.outputInterval = 0;
+
+	if (!adaptiveStep) {
+		return;
+	}
+
+	if (!integrator->setTimeStep(state.dTime)) {
+		chatterBox.consoleMessage("The " + integrator->getName() + " only supports a fixed time step.", 1);
+		adaptiveStep = false;
+		return;
+	}
+
+	//Snapshots stay evenly spaced in time.
+	state.outputInterval = state.outputFreq * state.dTime;
+	savedParticles.resize((size_t) 9 * state.nParticles);
+	chatterBox.consoleMessage("Adaptive time step from " + tos(dtMin) + " to " + tos(dtMax), 3);
+	if (!integrator->stepsVelocity()) {
+		chatterBox.consoleMessage("The " + integrator->getName() + " does not update velocities every step. Steps are not checked for heating.", 3);
+	}
+}
+
+void system::changeTimeStep(double dt) {
+	if (dt != state.dTime) {
+		state.dTime = dt;
+		integrator->setTimeStep(dt);
+	}
+}
+
+void system::adaptiveTimeStep() {
+	//Trim the step to land on the next snapshot time.
+	double tol = 1e-9 * state.outputInterval;
+	while (nextSnapshot <= state.currentTime + tol) {
+		nextSnapshot += state.outputInterval;
+	}
+	double toSnapshot = nextSnapshot - state.currentTime;
+	changeTimeStep((dtTarget < toSnapshot) ? dtTarget : toSnapshot);
+
+	//The current forces must not carry any particle too far.
+	double drift = maximumDrift();
+	while (drift > stepMaxDrift && state.dTime > dtMin) {
+		dtTarget = std::max(state.dTime * stepShrink, dtMin);
+		quietSteps = 0;
+		changeTimeStep((dtTarget < toSnapshot) ? dtTarget : toSnapshot);
+		drift = maximumDrift();
+	}
+
+	saveParticles();
+	integrator->saveState();
+
+	//A pair that is already inside stepMinGap may close by half its room to the overlap, so a
+	//contact that no time step can open does not stop the run.
+	bool checkHeat = integrator->stepsVelocity();
+	if (lastGap < 0) {
+		lastGap = minimumGap();
+		lastHeat = (checkHeat) ? (kineticTemperature() / state.temp) - 1.0 : 0.0;
+	}
+	double floorGap = std::min(stepMinGap, lastGap - 0.5 * (lastGap - overlapGap));
+	//The kinetic temperature of N particles spreads by sqrt(2/3N). Stay clear of that.
+	int nMobile = state.nParticles - state.nFrozen;
+	double maxHeat = std::max(stepMaxHeat, 6.0 * sqrt(2.0 / (3.0 * std::max(nMobile, 1))));
+
+	//Trial steps. Reject before the force managers see an overlap or the system heats up.
+	double gap = 0;
+	double heat = 0;
+	double trialHeat = std::numeric_limits<double>::max();
+	while (true) {
+		integrator->nextSystem(particles, &state);
+		rebuildCells();
+
+		gap = minimumGap();
+		heat = (checkHeat) ? (kineticTemperature() / state.temp) - 1.0 : 0.0;
+		bool closed = (gap < floorGap);
+		//A step that jumps over the limit is unstable. Noise while the system sits near the
+		//limit is left to the thermostat, or it would shrink the step each time.
+		bool hot = (heat > maxHeat) && (heat - lastHeat > 0.5 * maxHeat);
+		//Part of the heat can come from the last step, which a shorter step does not undo.
+		//Stop shrinking once a retry takes less than a quarter off the excess.
+		hot = hot && (heat < trialHeat - 0.25 * (trialHeat - maxHeat));
+		if (!closed && !hot) {
+			break;
+		}
+		if (state.dTime <= dtMin) {
+			if (closed) {
+				PSim::error::throwTimeStepError(state.dTime, gap);
+			}
+			//No smaller step is left, so the thermostat has to bring the temperature back.
+			break;
+		}
+
+		restoreParticles();
+		integrator->restoreState();
+		dtTarget = std::max(state.dTime * stepShrink, dtMin);
+		quietSteps = 0;
+		rejectedSteps++;
+		trialHeat = heat;
+		if (closed) {
+			chatterBox.consoleMessage("Step rejected at time step " + tos(state.dTime) + " closest pair: " + tos(gap), 3);
+		} else {
+			chatterBox.consoleMessage("Step rejected at time step " + tos(state.dTime) + " temperature: " + tos(state.temp * (1.0 + heat)), 3);
+		}
+		changeTimeStep((dtTarget < toSnapshot) ? dtTarget : toSnapshot);
+	}
+	lastGap = gap;
+	lastHeat = heat;
+
+	//Grow the time step after a run of quiet steps.
+	bool quiet = (gap >= stepSafeGap) && (drift <= 0.5 * stepMaxDrift) && (heat <= 0.5 * maxHeat);
+	quietSteps = (quiet) ? quietSteps + 1 : 0;
+	if (quietSteps >= stepGrowAfter) {
+		dtTarget = std::min(dtTarget * stepGrow, dtMax);
+		quietSteps = 0;
+	}
+
+	//Shrink the time step if the system is over the limit and still climbing after as many steps.
+	//A system that only holds its temperature is left to the thermostat.
+	if (heat <= maxHeat) {
+		hotSteps = 0;
+	} else if (hotSteps == 0) {
+		hotHeat = heat;
+		hotSteps = 1;
+	} else if (++hotSteps > stepGrowAfter) {
+		if (heat - hotHeat > 0.25 * maxHeat) {
+			dtTarget = std::max(dtTarget * stepShrink, dtMin);
+		}
+		hotHeat = heat;
+		hotSteps = 1;
+	}
+}
+
+double system::minimumGap() {
+	double gap = std::numeric_limits<double>::max();
+	int nMobile = state.nParticles - state.nFrozen;
+	int nRuns = state.runsPerCell();
+	int scale = state.cellScale;
+	int cellScaleSq = scale*scale;
+
+	//Frozen particles are sorted last and only met as neighbours, so a frozen pair is never measured.
+	//Their contacts cannot change, and no time step can open them.
+#pragma omp parallel for reduction(min:gap)
+	for (int index = 0; index < nMobile; index++) {
+		int indexOffset = 4*index;
+		type3<int> cell = type3<int>();
+		type3<int> cRef = type3<int>();
+
+		cell.x = floor(sortedParticles[indexOffset] / state.cellSize);
+		cell.y = floor(sortedParticles[indexOffset+1] / state.cellSize);
+		cell.z = floor(sortedParticles[indexOffset+2] / state.cellSize);
+
+		for (int x=-1; x<=1; x++) {
+			for (int y=-1; y<=1; y++) {
+				for (int z=-1; z<=1; z++) {
+					cRef.x = (cell.x + x + scale) % scale;
+					cRef.y = (cell.y + y + scale) % scale;
+					cRef.z = (cell.z + z + scale) % scale;
+					int hash = cRef.x + (scale * cRef.y) + (cellScaleSq * cRef.z);
+
+					for (int k = 0; k < nRuns; k++) {
+						int run = state.runIndex(hash, k);
+						int start = get<0>(cellStartEnd[run]);
+						if (start == emptyCell) {
+							continue;
+						}
+						int end = get<1>(cellStartEnd[run]);
+						for (int i = start; i < end; i++) {
+							if (i != index) {
+								int iOffset = 4*i;
+								double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
+																		sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
+																		state.boxSize);
+								double size = sortedParticles[indexOffset+3] + sortedParticles[iOffset+3];
+								double ratio = sqrt(rSquared) / size;
+								gap = (ratio < gap) ? ratio : gap;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	return gap;
+}
+
+double system::maximumDrift() {
+	double drift = 0;
+#pragma omp parallel for reduction(max:drift)
+	for (int i = 0; i < state.nParticles; i++) {
+		if (!particles[i]->isFrozen()) {
+			double fx = store->force[3*i];
+			double fy = store->force[3*i+1];
+			double fz = store->force[3*i+2];
+			double d = integrator->getDrift(sqrt((fx*fx) + (fy*fy) + (fz*fz)), particles[i]->getMass());
+			drift = (d > drift) ? d : drift;
+		}
+	}
+	return drift;
+}
+
+double system::kineticTemperature() {
+	double sum = 0;
+	int count = 0;
+#pragma omp parallel for reduction(+:sum,count)
+	for (int i = 0; i < state.nParticles; i++) {
+		if (!particles[i]->isFrozen()) {
+			double vx = store->vx[i];
+			double vy = store->vy[i];
+			double vz = store->vz[i];
+			sum += store->mass[i] * ((vx*vx) + (vy*vy) + (vz*vz));
+			count++;
+		}
+	}
+	return (count > 0) ? sum / (3.0 * count) : 0;
+}
+
+void system::saveParticles() {
+	int n = state.nParticles;
+	double* arrays[9] = {store->x, store->y, store->z, store->x0, store->y0, store->z0, store->vx, store->vy, store->vz};
+#pragma omp parallel for
+	for (int a = 0; a < 9; a++) {
+		std::copy(arrays[a], arrays[a] + n, &(savedParticles[(size_t) a*n]));
+	}
+}
+
+void system::restoreParticles() {
+	int n = state.nParticles;
+	double* arrays[9] = {store->x, store->y, store->z, store->x0, store->y0, store->z0, store->vx, store->vy, store->vz};
+#pragma omp parallel for
+	for (int a = 0; a < 9; a++) {
+		std::copy(&(savedParticles[(size_t) a*n]), &(savedParticles[(size_t) (a+1)*n]), arrays[a]);
+	}
+}
+
+}
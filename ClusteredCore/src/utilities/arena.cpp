@@ -0,0 +1,85 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "arena.h"
+#include "numa.h"
+
+namespace PSim {
+
+arena::arena(const char* owner, size_t chunkBytes) {
+	component = owner;
+	tracker = memoryTracker::owner();
+	chunkSize = chunkBytes;
+	current = 0;
+	offset = 0;
+}
+
+arena::~arena() {
+	release();
+}
+
+void* arena::take(size_t bytes) {
+	const size_t align = 64;
+	bytes = ((bytes + align - 1) / align) * align;
+
+	//Move on to the first kept chunk with room, or add a new one.
+	while (current < chunks.size() && offset + bytes > chunks[current].second) {
+		current++;
+		offset = 0;
+	}
+	if (current == chunks.size()) {
+		size_t size = (bytes > chunkSize) ? bytes : chunkSize;
+		chunks.push_back(std::make_pair((char*) numa::reserve(size, component, tracker), size));
+		offset = 0;
+	}
+
+	void* block = chunks[current].first + offset;
+	offset += bytes;
+	return block;
+}
+
+void arena::release() {
+	for (unsigned int c = 0; c < chunks.size(); c++) {
+		numa::release(chunks[c].first);
+	}
+	chunks.clear();
+	reset();
+}
+
+size_t arena::used() const {
+	size_t sum = offset;
+	for (size_t c = 0; c < current && c < chunks.size(); c++) {
+		sum += chunks[c].second;
+	}
+	return sum;
+}
+
+size_t arena::reserved() const {
+	size_t sum = 0;
+	for (unsigned int c = 0; c < chunks.size(); c++) {
+		sum += chunks[c].second;
+	}
+	return sum;
+}
+
+}
@@ -71,6 +71,20 @@ config::config(string fileName) {
 config::~config() {
 }
 
+void config::selectReplica(int k) {
+	std::string tag = "@" + std::to_string(k);
+	map<string, string> chosen;
+	for (map<string, string>::iterator it = options.begin(); it != options.end(); ++it) {
+		const string& key = it->first;
+		if (key.size() > tag.size() && key.compare(key.size() - tag.size(), tag.size(), tag) == 0) {
+			chosen[key.substr(0, key.size() - tag.size())] = it->second;
+		}
+	}
+	for (map<string, string>::iterator it = chosen.begin(); it != chosen.end(); ++it) {
+		options[it->first] = it->second;
+	}
+}
+
 template<typename T> T config::getParam(string key, T def) {
 	//Checks for key in the file.
 	T val = def;
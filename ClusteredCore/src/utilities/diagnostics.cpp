@@ -26,22 +26,31 @@ using namespace std;
 
 namespace PSim
 {
+thread_local ostream* Diagnostics::sink = NULL;
+
 void Diagnostics::startErrorLog(int _code, string _name) {
-	cout << "Error " << _code << ": " << _name << "\n";
+	ostream& out = (sink != NULL) ? *sink : cout;
+	out << "Error " << _code << ": " << _name << "\n";
 	addToChatter();
 }
 void Diagnostics::logErrorMessage(string _message) {
-	cout << "---" << _message << "\n";
+	ostream& out = (sink != NULL) ? *sink : cout;
+	out << "---" << _message << "\n";
 	addToChatter();
 }
 
 void Diagnostics::endErrorLog() {
-	cout << "-------END ERROR-------";
+	ostream& out = (sink != NULL) ? *sink : cout;
+	out << "-------END ERROR-------";
 	addToChatter();
 }
 void Diagnostics::consoleMessage(string _message, int level) {
 	string spacer = "";
 	for (int i = 0; i < level; i++) spacer = spacer + "-";
+	if (sink != NULL) {
+		*sink << spacer << _message << "\n";
+		return;
+	}
 	cout << spacer << _message << "\n";
 	addToChatter();
 }
@@ -51,6 +60,10 @@ void Diagnostics::consolePrompt(string _message) {
 }
 
 void Diagnostics::clearChatter(int count) {
+	//A log keeps every line.
+	if (sink != NULL) {
+		return;
+	}
 	int numLines = (count < 0) ? chatter : count;
 	if (numLines > 0) {
 		for (int i = 0; i < (numLines+1); i++) {
@@ -24,48 +24,102 @@
 
 namespace PSim {
 
+error::error(int code, std::string name) {
+	errorCode = code;
+	text = "Error " + tos(code) + ": " + name;
+}
+
+error error::begin(int code, std::string name) {
+	chatterBox.startErrorLog(code, name);
+	return error(code, name);
+}
+
 void error::throwInitializationError() {
-	chatterBox.startErrorLog(7701, "Could not create initial system.");
+	error e = begin(7701, "Could not create initial system.");
 	chatterBox.logErrorMessage("Try decreasing particle density.");
 	chatterBox.endErrorLog();
-	exit(7701);
+	throw e;
 }
 
 void error::throwCellBoundsError(int cx, int cy, int cz) {
-	chatterBox.startErrorLog(7702, "Unable to find: cells[" + tos(cx) + "][" + tos(cy) + "][" + tos(cz) + "].");
+	error e = begin(7702, "Unable to find: cells[" + tos(cx) + "][" + tos(cy) + "][" + tos(cz) + "].");
 	chatterBox.endErrorLog();
-	exit(7702);
+	throw e;
 }
 
 void error::throwParticleBoundsError(type3<double>* pos, int name) {
-	chatterBox.startErrorLog(7703, "Particle out of bounds.");
+	error e = begin(7703, "Particle out of bounds.");
 	chatterBox.logErrorMessage("Particle: " + tos(name) + " : " + tos(pos->x) + "," + tos(pos->y) + "," + tos(pos->z));
 	chatterBox.endErrorLog();
-	exit(7703);
+	throw e;
 }
 
 void error::throwParticleOverlapError(int hash, int nameI, int nameJ, double r) {
-	chatterBox.startErrorLog(7704, "Significant particle overlap. Consider time-step reduction");
+	error e = begin(7704, "Significant particle overlap. Consider time-step reduction");
 	chatterBox.logErrorMessage("Cell Hash: " + tos(hash));
 	chatterBox.logErrorMessage("1st Particle Index: " + tos(nameI));
 	chatterBox.logErrorMessage("2nd Particle Index: " + tos(nameJ));
 	chatterBox.logErrorMessage("Distance: " + tos(r));
 	chatterBox.endErrorLog();
-	exit(7704);
+	throw e;
 }
 
 void error::throwInfiniteForce() {
-	chatterBox.startErrorLog(7705, "Bad news bears; Numerically unstable system");
+	error e = begin(7705, "Bad news bears; Numerically unstable system");
 	chatterBox.logErrorMessage("Attempt reduction of concentration or decreased time step.");
 	chatterBox.endErrorLog();
-	exit(7705);
+	throw e;
 }
 
 void error::throwInputError() {
-	chatterBox.startErrorLog(7706, "Invalid input file");
+	error e = begin(7706, "Invalid input file");
+	chatterBox.endErrorLog();
+	throw e;
+}
+
+void error::throwTimeStepError(double dt, double gap) {
+	error e = begin(7707, "Adaptive time step reached dtMin and the step was still rejected.");
+	chatterBox.logErrorMessage("Time step: " + tos(dt));
+	chatterBox.logErrorMessage("Closest pair / contact: " + tos(gap));
+	chatterBox.logErrorMessage("Attempt decreasing dtMin or stepMinGap.");
+	chatterBox.endErrorLog();
+	throw e;
+}
+
+void error::throwSystemSizeError(std::string what, double need, double limit) {
+	error e = begin(7708, "The system is too large to start.");
+	chatterBox.logErrorMessage(what + ": " + tos(need) + " / Limit: " + tos(limit));
+	chatterBox.logErrorMessage("Attempt fewer particles, a smaller scale or a larger memoryBudget.");
+	chatterBox.endErrorLog();
+	throw e;
+}
+
+void error::throwSeedSizeError(int seedSize, int nParticles) {
+	error e = begin(7709, "The seed is larger than the system.");
+	chatterBox.logErrorMessage("Seed particles: " + tos(seedSize) + "^3 / Particles: " + tos(nParticles));
+	chatterBox.logErrorMessage("Attempt a smaller seedSize or more particles.");
 	chatterBox.endErrorLog();
-	exit(7706);
+	throw e;
+}
+
+void teamError::record() {
+#pragma omp critical(teamError)
+	{
+		if (!failed) {
+			first = std::current_exception();
+			failed = true;
+		}
+	}
 }
 
+void teamError::rethrow() {
+	if (!failed) {
+		return;
+	}
+	std::exception_ptr e = first;
+	first = nullptr;
+	failed = false;
+	std::rethrow_exception(e);
 }
 
+}
@@ -0,0 +1,127 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+#include "fft.h"
+
+namespace PSim {
+
+fft3d::fft3d(int n) {
+	size = nextPowerOfTwo(n);
+
+	//Twiddle factors for the largest butterfly.
+	twiddle = std::vector<std::complex<double>>(size / 2);
+	double twoPi = 8.0 * atan(1.0);
+	for (int k = 0; k < size / 2; k++) {
+		twiddle[k] = std::polar(1.0, -twoPi * k / size);
+	}
+
+	//Bit reversed ordering for the iterative transform.
+	reversal = std::vector<int>(size, 0);
+	int bits = 0;
+	while ((1 << bits) < size) {
+		bits++;
+	}
+	for (int k = 0; k < size; k++) {
+		int rev = 0;
+		for (int b = 0; b < bits; b++) {
+			rev |= ((k >> b) & 1) << (bits - 1 - b);
+		}
+		reversal[k] = rev;
+	}
+}
+
+fft3d::~fft3d() {
+}
+
+int fft3d::nextPowerOfTwo(int n) {
+	int p = 1;
+	while (p < n) {
+		p <<= 1;
+	}
+	return p;
+}
+
+void fft3d::transformLine(std::complex<double>* line, bool inverse) {
+	//Bit reversal permutation.
+	for (int k = 0; k < size; k++) {
+		int rev = reversal[k];
+		if (k < rev) {
+			std::swap(line[k], line[rev]);
+		}
+	}
+
+	//Butterflies.
+	for (int len = 2; len <= size; len <<= 1) {
+		int half = len / 2;
+		int step = size / len;
+		for (int start = 0; start < size; start += len) {
+			for (int k = 0; k < half; k++) {
+				std::complex<double> w = twiddle[k * step];
+				if (inverse) {
+					w = std::conj(w);
+				}
+				std::complex<double> a = line[start + k];
+				std::complex<double> b = w * line[start + k + half];
+				line[start + k] = a + b;
+				line[start + k + half] = a - b;
+			}
+		}
+	}
+}
+
+void fft3d::transformAxis(std::complex<double>* grid, int stride, bool inverse) {
+	int nLines = size * size;
+#pragma omp parallel
+	{
+		//Contiguous copy of the line being transformed.
+		std::vector<std::complex<double>> line(size);
+#pragma omp for
+		for (int l = 0; l < nLines; l++) {
+			//Find the first point of the line.
+			int lo = l % stride;
+			int hi = l / stride;
+			int base = lo + (hi * stride * size);
+
+			for (int k = 0; k < size; k++) {
+				line[k] = grid[base + k * stride];
+			}
+			transformLine(line.data(), inverse);
+			for (int k = 0; k < size; k++) {
+				grid[base + k * stride] = line[k];
+			}
+		}
+	}
+}
+
+void fft3d::forward(std::complex<double>* grid) {
+	transformAxis(grid, 1, false);
+	transformAxis(grid, size, false);
+	transformAxis(grid, size * size, false);
+}
+
+void fft3d::backward(std::complex<double>* grid) {
+	transformAxis(grid, 1, true);
+	transformAxis(grid, size, true);
+	transformAxis(grid, size * size, true);
+}
+
+}
@@ -0,0 +1,130 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "memoryBudget.h"
+#include "system.h"
+#include <unistd.h>
+#include <cmath>
+
+namespace PSim {
+
+memoryBudget::memoryBudget(config* cfg) {
+	//The system and integrator read these again, so keep the console quiet.
+	cfg->hideOutput();
+
+	nParticles = cfg->getParam<int>("nParticles", 1000);
+	copies = 1;
+	double n = nParticles;
+	int scale = cfg->getParam<int>("scale", 4);
+	int nSpecies = std::max(cfg->getParam<int>("nSpecies", 1), 1);
+
+	//Frozen particles take a second set of runs in every cell.
+	bool frozen = (cfg->getParam<int>("freezeSeed", 0) && cfg->getParam<int>("seedSize", 0) > 0);
+	for (int s = 0; s < nSpecies && nSpecies > 1; s++) {
+		frozen = frozen || cfg->getParam<int>("frozen_" + tos(s), 0);
+	}
+	double cells = pow((double) scale, 3.0);
+	cellRuns = cells * nSpecies * (frozen ? 2 : 1);
+
+	//Store arrays and ids, the particle views and the two pointer tables.
+	entries.push_back(std::make_pair("particles",
+			(17 * n * sizeof(double)) + (n * sizeof(int)) + (n * (sizeof(particle) + 2 * sizeof(particle*)))));
+
+	//Sorted positions, hash index, run table, bins and mobile list.
+	double cellBytes = (4 * n * sizeof(double)) + (n * sizeof(tuple<int,int>)) + (cellRuns * sizeof(tuple<int,int>));
+	cellBytes += (4 * n * sizeof(double)) + (2 * n * sizeof(int)) + (n * sizeof(int));
+	//Order and scratch of the periodic reorder.
+	if (cfg->getParam<int>("reorderFreq", 100) > 0) {
+		cellBytes += (n * sizeof(int)) + (3 * n * sizeof(double));
+	}
+	entries.push_back(std::make_pair("cells", cellBytes));
+
+	//Two copies of the store, their particles and crossing counts for the snapshot writer.
+	if (cfg->getParam<int>("asyncOutput", 1)) {
+		entries.push_back(std::make_pair("output",
+				2 * ((17 * n * sizeof(double)) + (4 * n * sizeof(int)) + (n * (sizeof(particle) + 2 * sizeof(particle*))))));
+	}
+
+	if (cfg->getParam<int>("adaptiveStep", 0)) {
+		entries.push_back(std::make_pair("step control", 9 * n * sizeof(double)));
+	}
+
+	std::string name = cfg->getParam<std::string>("Integrator", "brownianIntegrator");
+	double integratorBytes = 0;
+	if (name == "brownianIntegrator") {
+		integratorBytes = brownianIntegrator::memoryEstimate(cfg);
+	} else if (name == "hydroIntegrator") {
+		integratorBytes = hydroIntegrator::memoryEstimate(cfg);
+	} else if (name == "ermakIntegrator") {
+		integratorBytes = ermakIntegrator::memoryEstimate(cfg);
+	} else if (name == "baoabIntegrator") {
+		integratorBytes = baoabIntegrator::memoryEstimate(cfg);
+	} else {
+		notCounted = name;
+	}
+	entries.push_back(std::make_pair("integrator", integratorBytes));
+
+	//Zero means the whole node.
+	double gb = cfg->getParam<double>("memoryBudget", 0);
+	limit = (gb > 0) ? gb * 1e9 : (double) sysconf(_SC_PHYS_PAGES) * (double) sysconf(_SC_PAGE_SIZE);
+
+	cfg->showOutput();
+}
+
+double memoryBudget::total() const {
+	double sum = 0;
+	for (unsigned int e = 0; e < entries.size(); e++) {
+		sum += entries[e].second;
+	}
+	return sum * copies;
+}
+
+void memoryBudget::report() {
+	chatterBox.consoleMessage("Memory budget:");
+	for (unsigned int e = 0; e < entries.size(); e++) {
+		chatterBox.consoleMessage(entries[e].first + ": " + tos(entries[e].second / 1e9) + " GB", 3);
+	}
+	if (copies > 1) {
+		chatterBox.consoleMessage("runs at once: " + tos(copies), 3);
+	}
+	chatterBox.consoleMessage("total: " + tos(total() / 1e9) + " GB of " + tos(limit / 1e9) + " GB", 3);
+	if (notCounted != "") {
+		chatterBox.consoleMessage("The " + notCounted + " library is not counted", 1);
+	}
+	chatterBox.consoleMessage("Force tables are not counted", 1);
+}
+
+void memoryBudget::enforce() {
+	if (nParticles > maxParticles) {
+		error::throwSystemSizeError("Particles", nParticles, maxParticles);
+	}
+	//Runs are addressed by int in cellStartEnd.
+	if (cellRuns > 2147483647.0) {
+		error::throwSystemSizeError("Cell runs", cellRuns, 2147483647.0);
+	}
+	if (total() > limit) {
+		error::throwSystemSizeError("Memory (GB)", total() / 1e9, limit / 1e9);
+	}
+}
+
+}
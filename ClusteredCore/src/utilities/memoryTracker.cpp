@@ -0,0 +1,129 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "memoryTracker.h"
+#include "defs.h"
+#include <fstream>
+#include <iterator>
+
+namespace PSim {
+
+std::map<const void*, memoryTracker::block> memoryTracker::blocks;
+std::mutex memoryTracker::lock;
+thread_local memoryTracker* memoryTracker::active = NULL;
+
+memoryTracker::memoryTracker() {
+	totalCurrent = 0;
+	totalPeak = 0;
+}
+
+memoryTracker::~memoryTracker() {
+	std::lock_guard<std::mutex> guard(lock);
+	for (auto b = blocks.begin(); b != blocks.end();) {
+		b = (b->second.owner == this) ? blocks.erase(b) : std::next(b);
+	}
+}
+
+memoryTracker* memoryTracker::process() {
+	//Never destroyed, so blocks freed during exit still find it.
+	static memoryTracker* tracker = new memoryTracker();
+	return tracker;
+}
+
+void memoryTracker::change(const std::string& component, size_t oldBytes, size_t newBytes) {
+	usage& use = components[component];
+	use.current = use.current - oldBytes + newBytes;
+	use.peak = (use.current > use.peak) ? use.current : use.peak;
+	totalCurrent = totalCurrent - oldBytes + newBytes;
+	totalPeak = (totalCurrent > totalPeak) ? totalCurrent : totalPeak;
+}
+
+void memoryTracker::add(const void* mem, size_t bytes, const std::string& component, memoryTracker* tracker) {
+	if (mem == NULL) {
+		return;
+	}
+	if (tracker == NULL) {
+		tracker = owner();
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	blocks[mem] = {tracker, component, bytes};
+	tracker->change(component, 0, bytes);
+}
+
+void memoryTracker::remove(const void* mem) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto b = blocks.find(mem);
+	if (b == blocks.end()) {
+		return;
+	}
+	b->second.owner->change(b->second.component, b->second.bytes, 0);
+	blocks.erase(b);
+}
+
+void memoryTracker::set(const std::string& component, size_t bytes) {
+	std::lock_guard<std::mutex> guard(lock);
+	change(component, components[component].current, bytes);
+}
+
+size_t memoryTracker::current(const std::string& component) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto use = components.find(component);
+	return (use == components.end()) ? 0 : use->second.current;
+}
+
+size_t memoryTracker::peak(const std::string& component) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto use = components.find(component);
+	return (use == components.end()) ? 0 : use->second.peak;
+}
+
+size_t memoryTracker::total() {
+	std::lock_guard<std::mutex> guard(lock);
+	return totalCurrent;
+}
+
+size_t memoryTracker::peakTotal() {
+	std::lock_guard<std::mutex> guard(lock);
+	return totalPeak;
+}
+
+void memoryTracker::report() {
+	std::lock_guard<std::mutex> guard(lock);
+	chatterBox.consoleMessage("Memory in use (MB, current / peak):");
+	for (auto use = components.begin(); use != components.end(); ++use) {
+		chatterBox.consoleMessage(use->first + ": " + tos(use->second.current / 1e6) + " / " + tos(use->second.peak / 1e6), 3);
+	}
+	chatterBox.consoleMessage("total: " + tos(totalCurrent / 1e6) + " / " + tos(totalPeak / 1e6), 3);
+}
+
+void memoryTracker::write(std::string fileName, double currentTime) {
+	std::lock_guard<std::mutex> guard(lock);
+	std::ofstream myFile;
+	myFile.open(fileName, std::ios_base::app);
+	for (auto use = components.begin(); use != components.end(); ++use) {
+		myFile << currentTime << " " << use->first << " " << use->second.current << " " << use->second.peak << "\n";
+	}
+	myFile.close();
+}
+
+}
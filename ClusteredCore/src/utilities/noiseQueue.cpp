@@ -0,0 +1,180 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "noiseQueue.h"
+
+namespace PSim {
+
+noiseQueue::noiseQueue(config* cfg, uint64_t seed, int n, int width, bool planar) {
+	this->seed = seed;
+	this->n = n;
+	this->width = width;
+	this->planar = planar;
+	ids = NULL;
+
+	async = cfg->getParam<int>("asyncNoise", 1);
+	threads = cfg->getParam<int>("noiseThreads", 1);
+
+	for (int b = 0; b < 2; b++) {
+		buffers[b] = numa::allocate<double>((size_t) width * n, "noise");
+		held[b] = 0;
+		valid[b] = false;
+	}
+	front = 0;
+	kept = false;
+	refill = false;
+	pending = false;
+	stopping = false;
+	jobBuffer = 0;
+	jobStep = 0;
+}
+
+noiseQueue::~noiseQueue() {
+	if (producer.joinable()) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			stopping = true;
+		}
+		work.notify_one();
+		producer.join();
+	}
+	numa::release(buffers[0]);
+	numa::release(buffers[1]);
+}
+
+void noiseQueue::produce() {
+	//The producer keeps its own small team, so it does not compete with the force loop.
+	numa::unpin();
+	omp_set_num_threads(threads);
+	std::unique_lock<std::mutex> guard(lock);
+	while (true) {
+		work.wait(guard, [this]() { return pending || stopping; });
+		if (stopping) {
+			return;
+		}
+		int b = jobBuffer;
+		uint64_t step = jobStep;
+		guard.unlock();
+		fill(b, step);
+		guard.lock();
+		pending = false;
+		done.notify_all();
+	}
+}
+
+void noiseQueue::wait() {
+	std::unique_lock<std::mutex> guard(lock);
+	done.wait(guard, [this]() { return !pending; });
+}
+
+void noiseQueue::fill(int b, uint64_t step) {
+	if (planar) {
+		philox::fillGaussianPlanar(seed, step, n, width, buffers[b], ids);
+	} else {
+		philox::fillGaussian(seed, step, n, width, buffers[b], ids);
+	}
+	held[b] = step;
+	valid[b] = true;
+}
+
+void noiseQueue::fillInTeam(int b, uint64_t step) {
+	if (planar) {
+		philox::fillGaussianPlanarInTeam(seed, step, n, width, buffers[b], ids);
+	} else {
+		philox::fillGaussianInTeam(seed, step, n, width, buffers[b], ids);
+	}
+#pragma omp single
+	{
+		held[b] = step;
+		valid[b] = true;
+	}
+}
+
+const double* noiseQueue::takeInTeam(uint64_t step) {
+#pragma omp single
+	{
+		wait();
+		int back = 1 - front;
+		refill = (!valid[back] || held[back] != step);
+	}
+	if (refill) {
+		fillInTeam(1 - front, step);
+	}
+#pragma omp single
+	{
+		front = 1 - front;
+		valid[front] = false;
+		kept = true;
+	}
+	return buffers[front];
+}
+
+const double* noiseQueue::take(uint64_t step) {
+	wait();
+
+	//A rejected or skipped step leaves the wrong noise in the back buffer.
+	int back = 1 - front;
+	if (!valid[back] || held[back] != step) {
+		fill(back, step);
+	}
+
+	front = back;
+	valid[front] = false;
+	kept = true;
+	return buffers[front];
+}
+
+void noiseQueue::rewind(uint64_t step) {
+	//The producer may still be filling the back buffer with the next step.
+	wait();
+	int back = 1 - front;
+	valid[back] = false;
+	if (kept && held[front] == step) {
+		//The taken buffer becomes the back buffer again, so the next take finds it.
+		front = back;
+		valid[1 - front] = true;
+	}
+	kept = false;
+}
+
+void noiseQueue::prefetch(uint64_t step) {
+	wait();
+	int back = 1 - front;
+	if (!async) {
+		valid[back] = false;
+		return;
+	}
+
+	if (!producer.joinable()) {
+		producer = std::thread(&noiseQueue::produce, this);
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobBuffer = back;
+		jobStep = step;
+		pending = true;
+	}
+	work.notify_one();
+}
+
+}
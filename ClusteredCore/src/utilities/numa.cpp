@@ -0,0 +1,155 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+
+#include "numa.h"
+#include "defs.h"
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <vector>
+#include <algorithm>
+
+namespace PSim {
+
+bool numa::hugePages = true;
+
+//Affinity of the process before any pinning.
+static cpu_set_t startMask;
+static bool startMaskSaved = false;
+
+void numa::configure(config* cfg) {
+	//Older settings files name the team size 'threads'.
+	int legacyThreads = 1;
+	if (cfg->containsKey("threads")) {
+		legacyThreads = cfg->getParam<int>("threads", 1);
+		chatterBox.consoleMessage("Option 'threads' is replaced by 'ompThreads'", 1);
+	}
+	if (cfg->containsKey("omp_dynamic")) {
+		chatterBox.consoleMessage("Option 'omp_dynamic' is ignored. Teams are static so threads keep their pages", 1);
+	}
+
+	int threads = cfg->getParam<int>("ompThreads", legacyThreads);
+	std::string pinning = cfg->getParam<std::string>("threadPinning", "none");
+	hugePages = (cfg->getParam<int>("hugePages", 1) != 0);
+
+	//A thread leaving the team would strand the pages it touched.
+	omp_set_dynamic(0);
+	if (threads > 0) {
+		omp_set_num_threads(threads);
+	}
+
+	if (!startMaskSaved) {
+		CPU_ZERO(&startMask);
+		startMaskSaved = (sched_getaffinity(0, sizeof(cpu_set_t), &startMask) == 0);
+	}
+
+	if (pinning == "compact") {
+		pinThreads(false);
+	} else if (pinning == "spread") {
+		pinThreads(true);
+	} else if (pinning != "none") {
+		chatterBox.consoleMessage("Unknown threadPinning '" + pinning + "'. Threads are not pinned", 1);
+	}
+}
+
+void numa::pinThreads(bool spread) {
+	if (!startMaskSaved) {
+		return;
+	}
+
+	//The cores we may run on, with the socket of each.
+	std::vector<std::pair<int,int>> cores;
+	for (int c = 0; c < CPU_SETSIZE; c++) {
+		if (!CPU_ISSET(c, &startMask)) {
+			continue;
+		}
+		int package = 0;
+		std::string path = "/sys/devices/system/cpu/cpu" + tos(c) + "/topology/physical_package_id";
+		std::ifstream topology(path.c_str());
+		if (topology) {
+			topology >> package;
+		}
+		cores.push_back(std::make_pair(package, c));
+	}
+	if (cores.empty()) {
+		return;
+	}
+	std::sort(cores.begin(), cores.end());
+
+	//Spread takes the first core of each socket, then the second, and so on.
+	if (spread) {
+		std::vector<std::pair<int,int>> ranked;
+		int rank = 0;
+		for (unsigned int k = 0; k < cores.size(); k++) {
+			rank = (k > 0 && cores[k].first == cores[k-1].first) ? rank + 1 : 0;
+			ranked.push_back(std::make_pair(rank, (int) k));
+		}
+		std::stable_sort(ranked.begin(), ranked.end());
+		std::vector<std::pair<int,int>> order;
+		for (unsigned int k = 0; k < ranked.size(); k++) {
+			order.push_back(cores[ranked[k].second]);
+		}
+		cores = order;
+	}
+
+	//The team is reused by every parallel region, so the pinning holds for the run.
+#pragma omp parallel
+	{
+		int core = cores[omp_get_thread_num() % cores.size()].second;
+		cpu_set_t mask;
+		CPU_ZERO(&mask);
+		CPU_SET(core, &mask);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &mask);
+	}
+
+	chatterBox.consoleMessage("Pinned " + tos(omp_get_max_threads()) + " threads over " + tos(cores.size()) + " cores", 1);
+}
+
+void numa::unpin() {
+	if (startMaskSaved) {
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &startMask);
+	}
+}
+
+void* numa::reserve(size_t bytes, const char* component, memoryTracker* tracker) {
+	bool huge = hugePages && (bytes >= hugePageSize);
+	size_t align = huge ? hugePageSize : 64;
+	if (huge) {
+		bytes = ((bytes + hugePageSize - 1) / hugePageSize) * hugePageSize;
+	}
+
+	void* mem = NULL;
+	if (posix_memalign(&mem, align, (bytes > 0) ? bytes : align) != 0) {
+		throw std::bad_alloc();
+	}
+#ifdef MADV_HUGEPAGE
+	//Only a hint. Kernels without transparent huge pages keep small pages.
+	if (huge) {
+		madvise(mem, bytes, MADV_HUGEPAGE);
+	}
+#endif
+	memoryTracker::add(mem, bytes, component, tracker);
+	return mem;
+}
+
+}
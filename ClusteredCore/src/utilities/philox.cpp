@@ -0,0 +1,108 @@
+/*The MIT License (MIT)
+
+ Copyright (c) [2015] [Sawyer Hopkins]
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.*/
+
+#include "philox.h"
+#include <algorithm>
+
+namespace PSim {
+
+void philox::fillGaussian(uint64_t seed, uint64_t step, int n, int width, double* out, const int* ids) {
+	fill(seed, step, n, width, out, width, 1, ids);
+}
+
+void philox::fillGaussianPlanar(uint64_t seed, uint64_t step, int n, int width, double* out, const int* ids) {
+	fill(seed, step, n, width, out, 1, n, ids);
+}
+
+void philox::fillGaussianInTeam(uint64_t seed, uint64_t step, int n, int width, double* out, const int* ids) {
+	fillInTeam(seed, step, n, width, out, width, 1, ids);
+}
+
+void philox::fillGaussianPlanarInTeam(uint64_t seed, uint64_t step, int n, int width, double* out, const int* ids) {
+	fillInTeam(seed, step, n, width, out, 1, n, ids);
+}
+
+void philox::fill(uint64_t seed, uint64_t step, int n, int width, double* out, int rowStride, int laneStride, const int* ids) {
+#pragma omp parallel
+	fillInTeam(seed, step, n, width, out, rowStride, laneStride, ids);
+}
+
+void philox::fillInTeam(uint64_t seed, uint64_t step, int n, int width, double* out, int rowStride, int laneStride, const int* ids) {
+	const int block = 256;
+	int streams = (width + 3) / 4;
+	int nBlocks = (n + block - 1) / block;
+	uint32_t key0 = (uint32_t) seed;
+	uint32_t key1 = (uint32_t) (seed >> 32);
+	uint32_t stepLo = (uint32_t) step;
+	uint32_t stepHi = (uint32_t) (step >> 32);
+
+	//Raw words of one stream for a block, stored by lane.
+	uint32_t bits[4 * block];
+	//Deviates of one stream for a block, stored by lane.
+	double dev[4 * block];
+	//Counter of each row in the block.
+	uint32_t rows[block];
+
+#pragma omp for
+	for (int b = 0; b < nBlocks; b++) {
+		int first = b * block;
+		int count = std::min(block, n - first);
+		for (int j = 0; j < count; j++) {
+			rows[j] = (ids != NULL) ? (uint32_t) ids[first + j] : (uint32_t) (first + j);
+		}
+
+		for (int s = 0; s < streams; s++) {
+			//Philox rounds. No branches, so this loop vectorizes.
+#pragma omp simd
+			for (int j = 0; j < count; j++) {
+				uint32_t c0 = rows[j];
+				uint32_t c1 = stepLo;
+				uint32_t c2 = stepHi;
+				uint32_t c3 = (uint32_t) s;
+				generate(c0, c1, c2, c3, key0, key1);
+				bits[j] = c0;
+				bits[block + j] = c1;
+				bits[2 * block + j] = c2;
+				bits[3 * block + j] = c3;
+			}
+
+			//Transform the whole block, lane by lane, so the math runs over unit stride planes.
+#pragma omp simd
+			for (int j = 0; j < count; j++) {
+				boxMuller(bits[j], bits[block + j], dev[j], dev[block + j]);
+				boxMuller(bits[2 * block + j], bits[3 * block + j], dev[2 * block + j], dev[3 * block + j]);
+			}
+
+			//Scatter into the particle rows or planes. Planes are a straight copy.
+			int lanes = std::min(4, width - (4 * s));
+			for (int c = 0; c < lanes; c++) {
+				double* lane = out + ((size_t) rowStride * first) + ((size_t) laneStride * (4 * s + c));
+				const double* plane = &dev[c * block];
+				for (int j = 0; j < count; j++) {
+					lane[(size_t) rowStride * j] = plane[j];
+				}
+			}
+		}
+	}
+}
+
+}
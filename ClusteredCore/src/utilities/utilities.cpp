@@ -59,8 +59,8 @@ void util::loadBar(double x0, int n, int w) {
 	//if ( (x != n) && (x % (n/100+1) != 0) ) return;
 	int x = (int) x0;
 
-	//Choose when to update console.
-	if (x != n)
+	//Choose when to update console. A redirected thread has no console to draw on.
+	if (x != n || chatterBox.redirected())
 		return;
 
 	double ratio = x / (double) n;
@@ -154,6 +154,9 @@ double util::powBinaryDecomp(double base, int exp) {
 }
 
 void util::setTerminalColour(Colour c) {
+	if (chatterBox.redirected()) {
+		return;
+	}
 	switch (c) {
 	case Black:
 		std::cout << __BLACK;
@@ -5,16 +5,22 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../src/analysis.cpp \
+../src/benchmark.cpp \
+../src/ensemble.cpp \
 ../src/main.cpp \
 ../src/runSim.cpp 
 
 OBJS += \
 ./src/analysis.o \
+./src/benchmark.o \
+./src/ensemble.o \
 ./src/main.o \
 ./src/runSim.o 
 
 CPP_DEPS += \
 ./src/analysis.d \
+./src/benchmark.d \
+./src/ensemble.d \
 ./src/main.d \
 ./src/runSim.d 
 
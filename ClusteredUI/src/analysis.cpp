@@ -45,6 +45,6 @@ void runAnalysis(std::queue<std::string>* analysisArgs)
 	config* cfg =new config(analysisName + "/settings.cfg");
 
 	util::writeTerminal("\nLoading particle system.\n", Colour::Green);
-	PSim::AnalysisSystem sys = PSim::AnalysisSystem(cfg, analysisName, timeStamp,NULL);
+	PSim::AnalysisSystem sys(cfg, analysisName, timeStamp, NULL);
 	sys.analysisManager(analysisArgs);
 }
@@ -0,0 +1,201 @@
+/*The MIT License (MIT)
+
+Copyright (c) [2015] [Sawyer Hopkins]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+
+#include "system.h"
+
+using namespace std;
+using namespace PSim;
+
+PSim::IIntegrator* loadIntegrator(config* cfg);
+
+/**
+ * @brief Runs one integrator on independent particles in a harmonic trap.
+ *
+ * Every particle sits in its own trap U = k r^2 / 2 at the centre of the box,
+ * so the exact distribution is gaussian with <r^2> = 3 kT / k. The particles
+ * start from that distribution, are equilibrated, and then sampled every step.
+ * @param cfg The benchmark settings.
+ * @param integratorName The integrator to test.
+ * @param dt The time step.
+ * @param error The relative error of <r^2>.
+ * @param noise The standard error of the estimate.
+ * @return False if the integrator went unstable.
+ */
+bool trapError(config* cfg, string integratorName, double dt, double* error, double* noise)
+{
+	int nPart = cfg->getParam<int>("benchParticles", 1000);
+	double k = cfg->getParam<double>("benchStiffness", 1.0);
+	double kT = cfg->getParam<double>("kT", 1.0);
+	double mass = cfg->getParam<double>("mass", 1.0);
+	double eqTime = cfg->getParam<double>("benchEquilibrate", 50.0);
+	double runTime = cfg->getParam<double>("benchTime", 200.0);
+	int boxSize = 1000;
+	double centre = 0.5 * boxSize;
+
+	cfg->setParam("Integrator", integratorName);
+	cfg->setParam("nParticles", nPart);
+	cfg->setParam("timeStep", dt);
+	PSim::IIntegrator* integrator = loadIntegrator(cfg);
+
+	systemState state = systemState();
+	state.nParticles = nPart;
+	state.nSpecies = 1;
+	state.nFrozen = 0;
+	state.boxSize = boxSize;
+	state.temp = kT;
+	state.dTime = dt;
+	state.currentTime = 0;
+
+	//Start from the exact distribution.
+	int seed = cfg->getParam<int>("seed", 90210);
+	double start[4];
+	particle** items = new particle*[nPart];
+	for (int i = 0; i < nPart; i++)
+	{
+		items[i] = new particle(i);
+		items[i]->setMass(mass);
+		philox::gaussian4(seed + 1, i, 0, 0, start);
+		type3<double> pos = type3<double>(centre + start[0] * sqrt(kT / k),
+				centre + start[1] * sqrt(kT / k), centre + start[2] * sqrt(kT / k));
+		items[i]->setPos(&pos, boxSize);
+		philox::gaussian4(seed + 1, i, 0, 1, start);
+		items[i]->setVX(start[0] * sqrt(kT / mass));
+		items[i]->setVY(start[1] * sqrt(kT / mass));
+		items[i]->setVZ(start[2] * sqrt(kT / mass));
+	}
+
+	int eqSteps = (int) (eqTime / dt);
+	int runSteps = (int) (runTime / dt);
+	//Time average of r^2 for each particle.
+	std::vector<double> sampled(nPart, 0.0);
+	bool stable = true;
+
+	for (int s = 0; (s < eqSteps + runSteps) && stable; s++)
+	{
+		for (int i = 0; i < nPart; i++)
+		{
+			double frc[3] = {-k * (items[i]->getX() - centre),
+					-k * (items[i]->getY() - centre), -k * (items[i]->getZ() - centre)};
+			items[i]->setForce(frc);
+		}
+
+		integrator->nextSystem(items, &state);
+		state.currentTime += dt;
+
+		for (int i = 0; i < nPart; i++)
+		{
+			double dx = items[i]->getX() - centre;
+			double dy = items[i]->getY() - centre;
+			double dz = items[i]->getZ() - centre;
+			double r2 = (dx * dx) + (dy * dy) + (dz * dz);
+			//A particle that has left the trap will never come back.
+			if (!(r2 < 0.01 * centre * centre))
+			{
+				stable = false;
+				break;
+			}
+			if (s >= eqSteps)
+			{
+				sampled[i] += r2;
+			}
+		}
+	}
+
+	if (stable)
+	{
+		//The particles are independent, so their spread gives the error bar.
+		double exact = 3.0 * kT / k;
+		double sum = 0;
+		double sumSq = 0;
+		for (int i = 0; i < nPart; i++)
+		{
+			double r2 = sampled[i] / (runSteps * exact);
+			sum += r2;
+			sumSq += r2 * r2;
+		}
+		double mean = sum / nPart;
+		*error = mean - 1.0;
+		*noise = sqrt(((sumSq / nPart) - (mean * mean)) / nPart);
+	}
+
+	for (int i = 0; i < nPart; i++)
+	{
+		delete items[i];
+	}
+	delete[] items;
+	delete integrator;
+
+	return stable;
+}
+
+void runBenchmark(std::queue<std::string>* benchmarkArgs)
+{
+	config* cfg = new config("settings.cfg");
+	cfg->hideOutput();
+
+	//Time steps to test.
+	std::vector<double> steps;
+	while (!benchmarkArgs->empty())
+	{
+		steps.push_back(atof(PSim::util::tryPop(benchmarkArgs).c_str()));
+	}
+	if (steps.empty())
+	{
+		steps = {0.01, 0.05, 0.1, 0.2, 0.5};
+	}
+
+	string names[2] = {"brownianIntegrator", "baoabIntegrator"};
+	std::vector<double> error(2 * steps.size());
+	std::vector<double> noise(2 * steps.size());
+	std::vector<bool> stable(2 * steps.size());
+
+	for (unsigned int s = 0; s < steps.size(); s++)
+	{
+		for (int n = 0; n < 2; n++)
+		{
+			stable[2*s+n] = trapError(cfg, names[n], steps[s], &(error[2*s+n]), &(noise[2*s+n]));
+		}
+	}
+
+	//The integrators log as they are built, so the table is written at the end.
+	util::writeTerminal("\nRelative error of <r^2> in a harmonic trap.\n", Colour::Green);
+	cout << "dt\t" << names[0] << "\t\t" << names[1] << "\n";
+	for (unsigned int s = 0; s < steps.size(); s++)
+	{
+		cout << steps[s];
+		for (int n = 0; n < 2; n++)
+		{
+			if (stable[2*s+n])
+			{
+				cout << "\t" << error[2*s+n] << " +/- " << noise[2*s+n];
+			}
+			else
+			{
+				cout << "\tunstable\t";
+			}
+		}
+		cout << "\n";
+	}
+
+	delete cfg;
+}
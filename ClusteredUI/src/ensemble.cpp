@@ -0,0 +1,222 @@
+/*The MIT License (MIT)
+
+Copyright (c) [2015] [Sawyer Hopkins]
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+
+#include "system.h"
+#include "memoryBudget.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+#include <exception>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace PSim;
+
+PSim::IIntegrator* loadIntegrator(config* cfg);
+PSim::defaultForceManager* buildForces(config* cfg);
+
+/**
+ * @brief Builds and runs one replica on the calling thread.
+ *
+ * The replica gets its own copy of the settings, its own force manager and
+ * integrator, and a trial directory under the ensemble. Its console output
+ * is written to console.txt in that directory, and its memory is counted
+ * in a tracker of its own.
+ * @param cfg The ensemble settings.
+ * @param k The replica.
+ * @param team The OpenMP team size of the replica.
+ * @param dirName The trial directory of the replica.
+ * @return The most memory the replica held, in bytes.
+ * @throws std::exception The error that ended the replica, once its output is closed.
+ */
+size_t runReplica(config* cfg, int k, int team, string dirName)
+{
+	config replica = *cfg;
+	replica.hideOutput();
+	//Seeds follow the replica unless a replica sets its own.
+	replica.setParam("seed", cfg->getParam<int>("seed", 90210) + k);
+	//Helper threads would share the core of a one thread replica.
+	if (team == 1)
+	{
+		if (!cfg->containsKey("asyncNoise")) { replica.setParam("asyncNoise", 0); }
+		if (!cfg->containsKey("asyncOutput")) { replica.setParam("asyncOutput", 0); }
+	}
+	replica.selectReplica(k);
+	replica.setParam("trialName", dirName);
+
+	mkdir(dirName.c_str(), 0777);
+	ofstream log(dirName + "/console.txt");
+	chatterBox.redirect(&log);
+	PSim::memoryTracker tracker;
+	PSim::memoryTracker::use(&tracker);
+
+	PSim::defaultForceManager* force = NULL;
+	PSim::IIntegrator* difeq = NULL;
+	PSim::system* sys = NULL;
+	std::exception_ptr failure;
+	try
+	{
+		force = buildForces(&replica);
+		//The force manager leaves the thread on a team of one.
+		omp_set_num_threads(team);
+		difeq = loadIntegrator(&replica);
+		sys = new PSim::system(&replica, difeq, force, dirName);
+
+		int endTime = replica.getParam<double>("endTime",1000);
+		sys->run(endTime);
+	}
+	catch (std::exception& e)
+	{
+		failure = std::current_exception();
+	}
+	//The system frees the integrator and forces once it is built.
+	if (sys != NULL)
+	{
+		delete sys;
+	}
+	else
+	{
+		delete difeq;
+		delete force;
+	}
+
+	PSim::memoryTracker::use(NULL);
+	chatterBox.redirect(NULL);
+	if (failure)
+	{
+		std::rethrow_exception(failure);
+	}
+	return tracker.peakTotal();
+}
+
+/**
+ * @brief Runs many independent replicas of the settings in one process.
+ *
+ * A pool of workers takes replicas in turn until all have run. Small
+ * systems get one thread each, so the pool holds one replica per core.
+ * Large systems get a team of threads each and fewer run at once.
+ *
+ * Settings (settings.cfg):
+ * ensembleSize - The number of replicas. The first argument after -e replaces it.
+ * ensembleThreads - Threads per replica. Default is one per ensembleParticlesPerThread particles.
+ * ensembleParticlesPerThread - Particles per thread when ensembleThreads is not set. Default 20000.
+ * key@k - Replaces key for replica k, for sweeps. Replica k uses seed + k unless seed@k is set.
+ */
+void runEnsemble(std::queue<std::string>* ensembleArgs)
+{
+	config* cfg = new config("settings.cfg");
+	cfg->showOutput();
+
+	int replicas = cfg->getParam<int>("ensembleSize", 1);
+	if (!ensembleArgs->empty())
+	{
+		replicas = atoi(util::tryPop(ensembleArgs).c_str());
+	}
+	string trialName = cfg->getParam<std::string>("trialName", "");
+	if (replicas < 1 || trialName == "")
+	{
+		util::writeTerminal("\n\nAn ensemble needs a trialName and at least one replica.\n\n", Colour::Red);
+		exit(100);
+	}
+
+	//Team size for the whole process. Every replica shares these cores.
+	PSim::numa::configure(cfg);
+	int cores = omp_get_max_threads();
+	int perThread = cfg->getParam<int>("ensembleParticlesPerThread", 20000);
+	perThread = (perThread > 0) ? perThread : 1;
+	int team = cfg->getParam<int>("ensembleThreads", cfg->getParam<int>("nParticles", 1000) / perThread);
+	team = std::max(1, std::min(team, cores));
+	int workers = std::max(1, std::min(cores / team, replicas));
+	cfg->hideOutput();
+
+	//Refuse a run that cannot fit before any replica is built.
+	PSim::memoryBudget budget(cfg);
+	budget.setCopies(workers);
+	budget.report();
+	budget.enforce();
+
+	chatterBox.consoleMessage("Ensemble of " + tos(replicas) + " replicas. " + tos(workers) + " at a time with "
+			+ tos(team) + " threads each.", 1);
+	util::writeTerminal("Ensemble initialization complete. Press y/n to continue: ", Colour::Blue);
+	std::string cont;
+	cin >> cont;
+	if (cont != "Y" && cont != "y")
+	{
+		exit(100);
+	}
+
+	mkdir(trialName.c_str(), 0777);
+	atomic<int> next(0);
+	mutex consoleLock;
+	//Replicas that ended on an error. The rest of the ensemble keeps running.
+	vector<int> failed;
+	vector<std::thread> pool;
+	for (int w = 0; w < workers; w++)
+	{
+		pool.push_back(std::thread([&]() {
+			//Workers start with the affinity of the main thread, which may be pinned to one core.
+			PSim::numa::unpin();
+			for (int k = next++; k < replicas; k = next++)
+			{
+				string dirName = trialName + "/replica-" + tos(k);
+				PSim::timer tmr = PSim::timer();
+				tmr.start();
+				try
+				{
+					size_t peak = runReplica(cfg, k, team, dirName);
+					tmr.stop();
+					lock_guard<mutex> hold(consoleLock);
+					chatterBox.consoleMessage("Replica " + tos(k) + " finished in " + tos(tmr.getElapsedSeconds()) + " s. Peak memory: "
+							+ tos(peak / 1e6) + " MB", 1);
+				}
+				catch (std::exception& e)
+				{
+					tmr.stop();
+					lock_guard<mutex> hold(consoleLock);
+					failed.push_back(k);
+					chatterBox.consoleMessage("Replica " + tos(k) + " failed after " + tos(tmr.getElapsedSeconds()) + " s. " + e.what(), 1);
+				}
+			}
+		}));
+	}
+	for (unsigned int w = 0; w < pool.size(); w++)
+	{
+		pool[w].join();
+	}
+
+	if (failed.empty())
+	{
+		util::writeTerminal("\nEnsemble complete.\n", Colour::Green);
+		return;
+	}
+	std::sort(failed.begin(), failed.end());
+	string list = "";
+	for (unsigned int f = 0; f < failed.size(); f++)
+	{
+		list += ((f > 0) ? ", " : "") + tos(failed[f]);
+	}
+	util::writeTerminal("\nEnsemble complete. " + tos((int) failed.size()) + " of " + tos(replicas) + " replicas failed: " + list
+			+ ". See console.txt in each.\n", Colour::Red);
+}
@@ -33,6 +33,8 @@ using namespace std;
 static inline void greeting();
 void runScript(string aName, string timeStamp);
 void runAnalysis(std::queue<std::string>* analysisArgs);
+void runBenchmark(std::queue<std::string>* benchmarkArgs);
+void runEnsemble(std::queue<std::string>* ensembleArgs);
 
 /********************************************//**
 *------------------MAIN PROGRAM------------------
@@ -42,9 +44,10 @@ void runAnalysis(std::queue<std::string>* analysisArgs);
  * @brief The program entry point.
  * @param argc Not implemented.
  * @param argv Not implemented.
- * @return 
+ * @return The code of the error that ended the run, or 0.
  */
 int main(int argc, char **argv)
+try
 {
 
 	//Program welcome.
@@ -53,6 +56,10 @@ int main(int argc, char **argv)
 	//Program flags.
 	bool isAnalysis = false;
 	std::queue<std::string> analysisArgs;
+	bool isBenchmark = false;
+	std::queue<std::string> benchmarkArgs;
+	bool isEnsemble = false;
+	std::queue<std::string> ensembleArgs;
 	string rewindName = "";
 	string timeStamp = "";
 
@@ -90,6 +97,32 @@ int main(int argc, char **argv)
 			}
 			i = (j-1);
 		}
+		//Flag for the integrator benchmark. Takes the time steps to test.
+		if (str.compare("-b")==0)
+		{
+			isBenchmark = true;
+			int j = i + 1;
+			while (j < argc)
+			{
+				string stArg(argv[j]);
+				benchmarkArgs.push(stArg);
+				j++;
+			}
+			i = (j-1);
+		}
+		//Flag for ensemble mode. Takes the number of replicas.
+		if (str.compare("-e")==0)
+		{
+			isEnsemble = true;
+			int j = i + 1;
+			while (j < argc)
+			{
+				string stArg(argv[j]);
+				ensembleArgs.push(stArg);
+				j++;
+			}
+			i = (j-1);
+		}
 		i++;
 	}
 
@@ -97,6 +130,14 @@ int main(int argc, char **argv)
 	{
 		runAnalysis(&analysisArgs);
 	}
+	else if (isBenchmark)
+	{
+		runBenchmark(&benchmarkArgs);
+	}
+	else if (isEnsemble)
+	{
+		runEnsemble(&ensembleArgs);
+	}
 	else
 	{
 		runScript(rewindName, timeStamp);
@@ -105,6 +146,11 @@ int main(int argc, char **argv)
 	//Debug code 0 -> No Error:
 	return 0;
 }
+catch (PSim::error& e)
+{
+	//The error log is already written, so only the code is left to return.
+	return e.code();
+}
 
 
 /********************************************//**
@@ -21,12 +21,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include "RecoverySystem.h"
+#include "memoryBudget.h"
 #include <dlfcn.h>
 
 using namespace std;
 using namespace PSim;
 
-PSim::defaultForceManager* loadForces(config* cfg)
+/**
+ * @brief Builds a force manager with the force library named in the config.
+ */
+PSim::defaultForceManager* buildForces(config* cfg)
 {
 	//Creates a force manager.
 	util::writeTerminal("Adding required forces.\n", Colour::Green);
@@ -64,12 +68,8 @@ PSim::defaultForceManager* loadForces(config* cfg)
 	PSim::defaultForceManager* force = new PSim::defaultForceManager();
 	force->addForce(loadForce);
 
-	util::writeTerminal("Creating force manager.\n", Colour::Green);
-	int num_threads = cfg->getParam<double>("threads",1);
-	force->setNumThreads(num_threads);
-
-	int num_dyn = cfg->getParam<double>("omp_dynamic",0);
-	force->setDynamic(num_dyn);
+	//Cell blocks each thread is dealt. Idle threads steal the rest.
+	force->setBlocksPerThread(cfg->getParam<int>("blocksPerThread", 8));
 
 	//Does not work on GCC 4.8 and below.
 	int num_dev = cfg->getParam<double>("omp_device",0);
@@ -78,14 +78,75 @@ PSim::defaultForceManager* loadForces(config* cfg)
 	return force;
 }
 
-PSim::system* loadSystem(config* cfg, std::string aName, std::string timeStamp, PSim::brownianIntegrator* difeq, PSim::defaultForceManager* force)
+PSim::defaultForceManager* loadForces(config* cfg)
+{
+	PSim::defaultForceManager* force = buildForces(cfg);
+
+	util::writeTerminal("Creating force manager.\n", Colour::Green);
+	//Team size and pinning. Must come before any particle arrays are allocated.
+	PSim::numa::configure(cfg);
+
+	return force;
+}
+
+PSim::IIntegrator* loadIntegrator(config* cfg)
+{
+	//Creates the integrator named in the config.
+	std::string integratorName = cfg->getParam<std::string>("Integrator","brownianIntegrator");
+
+	//Integrators built into the core.
+	if (integratorName == "brownianIntegrator")
+	{
+		return new PSim::brownianIntegrator(cfg);
+	}
+	else if (integratorName == "hydroIntegrator")
+	{
+		return new PSim::hydroIntegrator(cfg);
+	}
+	else if (integratorName == "ermakIntegrator")
+	{
+		return new PSim::ermakIntegrator(cfg);
+	}
+	else if (integratorName == "baoabIntegrator")
+	{
+		return new PSim::baoabIntegrator(cfg);
+	}
+
+	//Otherwise look for an integrator library, the same way as the forces.
+	std::string fileName = "./" + integratorName + ".so";
+	void* integratorLib = dlopen(fileName.c_str(), RTLD_LAZY);
+
+	//Throw error if the library does not exist.
+	if (!integratorLib)
+	{
+		util::writeTerminal("\n\nUnknown integrator: " + integratorName + "\n\n", Colour::Red);
+		exit(100);
+	}
+
+	dlerror();
+
+	//Make a factory to create the integrator instance.
+	PSim::create_Integrator* factory = (PSim::create_Integrator*) dlsym(integratorLib,"getIntegrator");
+	const char* err = dlerror();
+
+	//If the integrator is not properly implemented.
+	if (err)
+	{
+		util::writeTerminal("\n\nCould not find symbol: getIntegrator\n\n", Colour::Red);
+		exit(100);
+	}
+
+	return factory(cfg);
+}
+
+PSim::system* loadSystem(config* cfg, std::string aName, std::string timeStamp, PSim::IIntegrator* difeq, PSim::defaultForceManager* force)
 {
 	util::writeTerminal("\nLoading particle system.\n", Colour::Green);
 	PSim::RecoverySystem* sys = new PSim::RecoverySystem(cfg, aName, timeStamp, difeq, force);
 	return sys;
 }
 
-PSim::system* buildSystem(config* cfg, PSim::brownianIntegrator* difeq, PSim::defaultForceManager* force)
+PSim::system* buildSystem(config* cfg, PSim::IIntegrator* difeq, PSim::defaultForceManager* force)
 {
 	util::writeTerminal("\nCreating particle system.\n", Colour::Green);
 	//Creates the particle system.
@@ -119,11 +180,18 @@ void runScript(string aName, string timeStamp)
 	util::writeTerminal("Loading Forces.\n", Colour::Green);
 	PSim::defaultForceManager* force = loadForces(cfg);
 
+	/*---------------MEMORY---------------*/
+
+	//Refuse a run that cannot fit before the particle arrays are allocated.
+	PSim::memoryBudget budget(cfg);
+	budget.report();
+	budget.enforce();
+
 	/*-------------INTEGRATOR-------------*/
 
 	//Create the integrator.
 	util::writeTerminal("Creating integrator.\n", Colour::Green);
-	PSim::brownianIntegrator * difeq = new PSim::brownianIntegrator(cfg);
+	PSim::IIntegrator* difeq = loadIntegrator(cfg);
 
 	/*---------------SYSTEM---------------*/
 
@@ -1,5 +1,7 @@
 #include "forceManager.h"
 #include "utilities.h"
+#include "pmeSolver.h"
+#include "pairTable.h"
 
 using namespace PSim;
 using namespace std;
@@ -18,11 +20,14 @@ private:
 
 		//Variables vital to the force.
 		double kT;
-		double wellDepth;
 		double yukStr;
 		int ljNum;
 		double cutOff;
 		double cutOffSquared;
+
+		//Per species pair constants.
+		pairTable wellDepth;
+		pairTable pairCutOffSquared;
 		double debyeLength; //k
 		double debyeInv;
 		double mass; // m
@@ -30,6 +35,43 @@ private:
 		bool output;
 		long callCount;
 
+		//Long range electrostatics.
+		bool useSPME;
+		double charge;
+		double chargeSq;
+		PSim::pmeSolver* pme;
+
+		//Cell kernel specialized on ljNum.
+		typedef type3<double> (LennardJones::*cellKernel)(int, int, int, double*, vector<tuple<int,int>>*, systemState*);
+		cellKernel kernel;
+
+		//Tiled kernel specialized on ljNum.
+		typedef void (LennardJones::*tileKernel)(int, PSim::cellTile*, double*, double*, vector<tuple<int,int>>*, vector<tuple<int,int>>*, systemState*);
+		tileKernel tileKern;
+		//Use the tiled traversal.
+		bool tiled;
+
+		/**
+		 * @brief Cell iteration with the LJ exponent fixed at compile time.
+		 * @param N The LJ exponent. Zero falls back to the runtime ljNum.
+		 */
+		template<int N> type3<double> iterCellsPow(int index, int species, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+		/**
+		 * @brief Tiled cell traversal with the LJ exponent fixed at compile time.
+		 * @param N The LJ exponent. Zero falls back to the runtime ljNum.
+		 */
+		template<int N> void tileCellsPow(int hash, PSim::cellTile* tile, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+		/**
+		 * @brief The net LJ and electrostatic force between a pair.
+		 * @param r The distance between the pair.
+		 * @param rSquared The squared distance between the pair.
+		 * @param size The sum of the pair radii.
+		 * @param depth The well depth of the pair.
+		 * @param pairCutSq The squared LJ cutoff of the pair.
+		 * @return Positive is attractive; Negative repulsive.
+		 */
+		template<int N> double pairForce(double r, double rSquared, double size, double depth, double pairCutSq);
+
 	public:
 
 		/**
@@ -52,6 +94,20 @@ private:
 		 * @param items All particles in the system.
 		 */
 		void getAcceleration(int index, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+		/**
+		 * @brief Solves the reciprocal space electrostatics when SPME is enabled.
+		 */
+		void preRoutine(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+		/**
+		 * @brief Flag for the tiled traversal.
+		 */
+		bool isTiled() { return tiled; }
+		/**
+		 * @brief Get the force on every particle in a home cell from a staged tile.
+		 */
+		void getTileAcceleration(int hash, PSim::cellTile* tile, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state) {
+			(this->*tileKern)(hash, tile, sortedParticles, particleForce, particleHashIndex, cellStartEnd, state);
+		}
 		/**
 		 * @brief Flag for a force dependent time.
 		 * @return True for time dependent. False otherwise. 
@@ -62,9 +118,12 @@ private:
 		 * @param boxSize The size of the system.
 		 * @param time The current system time.
 		 * @param index The particle to find the force on.
+		 * @param species The species of the index particle.
 		 * @param itemCell The cell to check for interactions in.
 		 */
-		type3<double> iterCells(int index, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state);
+		type3<double> iterCells(int index, int species, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state) {
+			return (this->*kernel)(index, species, hash, sortedParticles, cellStartEnd, state);
+		}
 		
 		void quench(systemState* state);
 
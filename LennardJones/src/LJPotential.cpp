@@ -24,6 +24,7 @@ SOFTWARE.*/
 
 LennardJones::~LennardJones()
 {
+	delete pme;
 }
 
 LennardJones::LennardJones(config* cfg)
@@ -32,7 +33,13 @@ LennardJones::LennardJones(config* cfg)
 	name = "Lennard Jones";
 
 	kT = cfg->getParam<double>("kT", 1.0);
-	wellDepth = cfg->getParam<double>("wellDepth", 10.0);
+
+	//Number of particle species.
+	int nSpecies = cfg->getParam<int>("nSpecies", 1);
+	nSpecies = (nSpecies < 1) ? 1 : nSpecies;
+
+	//Get the well depth of each species pair.
+	wellDepth = pairTable(cfg, "wellDepth", 10.0, nSpecies);
 
 	//Get the radius
 	radius = cfg->getParam<double>("radius",0.5);
@@ -46,96 +53,275 @@ LennardJones::LennardJones(config* cfg)
 	//Get the well depth
 	ljNum = cfg->getParam<int>("ljNum",18.0);
 
-	//Get the cutoff range
+	//Get the cutoff range of each species pair.
 	cutOff = cfg->getParam<double>("cutOff",2.5);
 	cutOffSquared = cutOff*cutOff;
+	pairTable pairCutOff = pairTable(cfg, "cutOff", cutOff, nSpecies);
+	pairCutOffSquared = pairTable(nSpecies, cutOffSquared);
+	for (int i=0; i<nSpecies; i++) {
+		for (int j=i; j<nSpecies; j++) {
+			pairCutOffSquared.set(i, j, pairCutOff(i,j)*pairCutOff(i,j));
+		}
+	}
 
 	//Get the debye length for the system.
 	debyeLength = cfg->getParam<double>("debyeLength",0.5);
 	debyeInv = 1.0 / debyeLength;
 
+	//Pick the electrostatics model.
+	//yukawa: screened short range repulsion.
+	//spme: full coulomb repulsion split by smooth particle mesh ewald.
+	std::string electrostatics = cfg->getParam<std::string>("electrostatics","yukawa");
+	useSPME = (electrostatics == "spme");
+	charge = cfg->getParam<double>("charge",1.0);
+	chargeSq = charge*charge;
+	pme = NULL;
+
+	if (useSPME)
+	{
+		//Bjerrum length in units of the particle diameter.
+		double bjerrum = cfg->getParam<double>("bjerrumLength",0.2);
+		//Real space term decays to erfc(3.5) ~ 1e-6 at the cutoff.
+		double ewaldAlpha = cfg->getParam<double>("ewaldAlpha",3.5 / cutOff);
+		int pmeGrid = cfg->getParam<int>("pmeGrid",0);
+		int pmeOrder = cfg->getParam<int>("pmeOrder",4);
+		pme = new PSim::pmeSolver(pmeGrid, pmeOrder, ewaldAlpha, kT*bjerrum);
+		PSim::util::writeTerminal("---Using SPME electrostatics.\n", PSim::Colour::Cyan);
+	}
+	else if (electrostatics != "yukawa")
+	{
+		PSim::util::writeTerminal("---Unknown electrostatics: " + electrostatics + ". Using yukawa.\n", PSim::Colour::Magenta);
+	}
+
 	output = true;
 
 	callCount=0;
 
+	//Stage each home cell and its neighbors once.
+	tiled = cfg->getParam<int>("tiledForce",1);
+
+	//Pick the kernel instantiated for the exponent.
+	switch (ljNum) {
+		case 12: kernel = &LennardJones::iterCellsPow<12>; tileKern = &LennardJones::tileCellsPow<12>; break;
+		case 18: kernel = &LennardJones::iterCellsPow<18>; tileKern = &LennardJones::tileCellsPow<18>; break;
+		case 24: kernel = &LennardJones::iterCellsPow<24>; tileKern = &LennardJones::tileCellsPow<24>; break;
+		case 36: kernel = &LennardJones::iterCellsPow<36>; tileKern = &LennardJones::tileCellsPow<36>; break;
+		case 48: kernel = &LennardJones::iterCellsPow<48>; tileKern = &LennardJones::tileCellsPow<48>; break;
+		default:
+			kernel = &LennardJones::iterCellsPow<0>;
+			tileKern = &LennardJones::tileCellsPow<0>;
+			PSim::util::writeTerminal("---No fixed kernel for ljNum: " + tos(ljNum) + ". Using runtime power.\n", PSim::Colour::Magenta);
+			break;
+	}
+
 	PSim::util::writeTerminal("---Lennard Jones Potential successfully added.\n\n", PSim::Colour::Cyan);
 }
 
-type3<double> LennardJones::iterCells(int index, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state)
+template<int N>
+double LennardJones::pairForce(double r, double rSquared, double size, double depth, double pairCutSq)
 {
-	int start = get<0>((*cellStartEnd)[hash]);
-
-	type3<double> cellForce = type3<double>();
-
-	if (start != 0xffffffff) {
-		int end = get<1>((*cellStartEnd)[hash]);
-		for (int i=start; i<end; i++) {
-			if (i != index) {
-				int indexOffset = 4*index;
-				int iOffset = 4*i;
-
-				double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
-																	sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
-																	state->boxSize);
-
-				//If the particles are in the potential well.
-				if (rSquared < cutOffSquared)
-				{
-					double r = sqrt(rSquared);
-					//If the particles overlap there are problems.
-					double size = (sortedParticles[indexOffset+3] + sortedParticles[iOffset+3]);
-					if(r< (0.8*size) )
-					{
-						PSim::error::throwParticleOverlapError(hash, i, index, r);
-					}
-
-					//-------------------------------------
-					//-----------FORCE CALCULATION---------
-					//-------------------------------------
-
-					//Predefinitions.
-					double rInv = (1.0  / r);
-					double yukExp = std::exp(-1.0 * (r * debyeInv));
-					double LJ = PSim::util::powBinaryDecomp((size / r),ljNum);
-
-					//Attractive LJ.
-					double attract = ((2.0*LJ) - 1.0);
-					attract *= (4.0*ljNum*rInv*LJ);
+	//Predefinitions.
+	double rInv = (1.0  / r);
+
+	//Attractive LJ.
+	double attract = 0.0;
+	if (rSquared < pairCutSq)
+	{
+		double LJ = (N > 0) ? PSim::util::powFixed<N>(size / r) : PSim::util::powBinaryDecomp((size / r),ljNum);
+		attract = ((2.0*LJ) - 1.0);
+		attract *= (4.0*((N > 0) ? N : ljNum)*rInv*LJ);
+	}
 
-					//Repulsive Yukawa.
-					double repel = yukExp;
-					repel *= (rInv*rInv*(debyeLength + r)*yukStr);
+	if (useSPME)
+	{
+		//Real space ewald. The reciprocal part is added per particle.
+		return -kT*depth*attract - chargeSq*pme->realSpaceForce(r);
+	}
 
-					double fNet = -kT*wellDepth*(attract+repel);
+	//Repulsive Yukawa.
+	double yukExp = std::exp(-1.0 * (r * debyeInv));
+	double repel = yukExp;
+	repel *= (rInv*rInv*(debyeLength + r)*yukStr);
 
-					//Positive is attractive; Negative repulsive.
-					//fNet = -fNet;
+	return -kT*depth*(attract+repel);
+}
 
-					//-------------------------------------
-					//------NORMALIZATION AND SETTING------
-					//-------------------------------------
+template<int N>
+type3<double> LennardJones::iterCellsPow(int index, int species, int hash, double* sortedParticles, vector<tuple<int,int>>* cellStartEnd, systemState* state)
+{
+	type3<double> cellForce = type3<double>();
+	int nSpecies = state->nSpecies;
+	int nRuns = state->runsPerCell();
+
+	//Particles in a cell are sorted by species. Hoist the pair constants for each run.
+	//Frozen particles follow in a second block of runs.
+	for (int k=0; k<nRuns; k++) {
+		int run = state->runIndex(hash, k);
+		int s = k % nSpecies;
+		int start = get<0>((*cellStartEnd)[run]);
+
+		if (start != emptyCell) {
+			int end = get<1>((*cellStartEnd)[run]);
+			double depth = wellDepth(species, s);
+			double pairCutSq = pairCutOffSquared(species, s);
+			//The real space ewald term always runs to the global cutoff.
+			double runCutSq = (useSPME && cutOffSquared > pairCutSq) ? cutOffSquared : pairCutSq;
+
+			for (int i=start; i<end; i++) {
+				if (i != index) {
+					int indexOffset = 4*index;
+					int iOffset = 4*i;
+
+					double rSquared = PSim::util::pbcDist(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
+																		sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
+																		state->boxSize);
+
+					//If the particles are in the potential well.
+					if (rSquared < runCutSq)
+					{
+						double r = sqrt(rSquared);
+						//If the particles overlap there are problems.
+						double size = (sortedParticles[indexOffset+3] + sortedParticles[iOffset+3]);
+						if(r< (0.8*size) )
+						{
+							PSim::error::throwParticleOverlapError(hash, i, index, r);
+						}
+
+						//-------------------------------------
+						//-----------FORCE CALCULATION---------
+						//-------------------------------------
+
+						double fNet = pairForce<N>(r, rSquared, size, depth, pairCutSq);
+
+						//Positive is attractive; Negative repulsive.
+						//fNet = -fNet;
+
+						//-------------------------------------
+						//------NORMALIZATION AND SETTING------
+						//-------------------------------------
+
+						//Normalize the force.
+						double unitVec[3] {0.0,0.0,0.0};
+						PSim::util::unitVectorAdv(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
+															sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
+															unitVec, r, state->boxSize);
+
+						//Updates the acceleration.;
+						cellForce.x += fNet*unitVec[0];
+						cellForce.y += fNet*unitVec[1];
+						cellForce.z += fNet*unitVec[2];
+					}
+				}
+			}
+		}
+	}
+	return cellForce;
+}
 
-					//Normalize the force.
-					double unitVec[3] {0.0,0.0,0.0};
-					PSim::util::unitVectorAdv(sortedParticles[indexOffset], sortedParticles[indexOffset+1], sortedParticles[indexOffset+2],
-														sortedParticles[iOffset], sortedParticles[iOffset+1], sortedParticles[iOffset+2],
-														unitVec, r, state->boxSize);
+template<int N>
+void LennardJones::tileCellsPow(int hash, PSim::cellTile* tile, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state)
+{
+	if (!tile->load(hash, sortedParticles, cellStartEnd, state)) {
+		return;
+	}
+	const double* tx = tile->x;
+	const double* ty = tile->y;
+	const double* tz = tile->z;
+	const double* tr = tile->r;
+	const int* tIndex = tile->index;
+	int nRuns = tile->runs.size();
+
+	for (unsigned int h=0; h<tile->home.size(); h++) {
+		int species = tile->home[h].species;
+
+		for (int index=tile->home[h].begin; index<tile->home[h].end; index++) {
+			int indexOffset = 4*index;
+			double xi = sortedParticles[indexOffset];
+			double yi = sortedParticles[indexOffset+1];
+			double zi = sortedParticles[indexOffset+2];
+			double ri = sortedParticles[indexOffset+3];
+			double netForce[3] = {0.0,0.0,0.0};
+
+			//Sum each neighbor cell on its own, as in the per particle traversal.
+			type3<double> cellForce = type3<double>();
+			int cell = -1;
+
+			for (int k=0; k<nRuns; k++) {
+				const PSim::cellTile::tileRun& run = tile->runs[k];
+				if (run.cell != cell) {
+					netForce[0] += cellForce.x;
+					netForce[1] += cellForce.y;
+					netForce[2] += cellForce.z;
+					cellForce = type3<double>();
+					cell = run.cell;
+				}
 
-					//Updates the acceleration.;
-					cellForce.x += fNet*unitVec[0];
-					cellForce.y += fNet*unitVec[1];
-					cellForce.z += fNet*unitVec[2];
+				double depth = wellDepth(species, run.species);
+				double pairCutSq = pairCutOffSquared(species, run.species);
+				//The real space ewald term always runs to the global cutoff.
+				double runCutSq = (useSPME && cutOffSquared > pairCutSq) ? cutOffSquared : pairCutSq;
+
+				for (int j=run.begin; j<run.end; j++) {
+					if (tIndex[j] != index) {
+						double rSquared = PSim::util::pbcDist(xi, yi, zi, tx[j], ty[j], tz[j], state->boxSize);
+
+						//If the particles are in the potential well.
+						if (rSquared < runCutSq)
+						{
+							double r = sqrt(rSquared);
+							//If the particles overlap there are problems.
+							double size = (ri + tr[j]);
+							if(r< (0.8*size) )
+							{
+								PSim::error::throwParticleOverlapError(run.hash, tIndex[j], index, r);
+							}
+
+							double fNet = pairForce<N>(r, rSquared, size, depth, pairCutSq);
+
+							//Normalize the force.
+							double unitVec[3] {0.0,0.0,0.0};
+							PSim::util::unitVectorAdv(xi, yi, zi, tx[j], ty[j], tz[j], unitVec, r, state->boxSize);
+
+							//Updates the acceleration.
+							cellForce.x += fNet*unitVec[0];
+							cellForce.y += fNet*unitVec[1];
+							cellForce.z += fNet*unitVec[2];
+						}
+					}
 				}
 			}
+			netForce[0] += cellForce.x;
+			netForce[1] += cellForce.y;
+			netForce[2] += cellForce.z;
+
+			if (useSPME)
+			{
+				const double* recip = pme->getForce(index);
+				netForce[0] += recip[0];
+				netForce[1] += recip[1];
+				netForce[2] += recip[2];
+			}
+
+			int realIndex = 3*get<1>((*particleHashIndex)[index]);
+			particleForce[realIndex] = netForce[0];
+			particleForce[realIndex+1] = netForce[1];
+			particleForce[realIndex+2] = netForce[2];
 		}
 	}
-	return cellForce;
 }
 
 void LennardJones::quench(systemState* state)
 {
 }
 
+void LennardJones::preRoutine(double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state)
+{
+	if (useSPME)
+	{
+		pme->computeForces(sortedParticles, charge, state);
+	}
+}
+
 void LennardJones::getAcceleration(int index, double* sortedParticles, double* particleForce, vector<tuple<int,int>>* particleHashIndex, vector<tuple<int,int>>* cellStartEnd, systemState* state)
 {
 	int hash = 0;
@@ -146,6 +332,7 @@ void LennardJones::getAcceleration(int index, double* sortedParticles, double* p
 	int scale = state->cellScale;
 	int cellScaleSq = scale*scale;
 	int realIndex = 3*get<1>((*particleHashIndex)[index]);
+	int species = get<0>((*particleHashIndex)[index]) % state->nSpecies;
 
 	cell.x = floor(sortedParticles[indexOffset] / state->cellSize);
 	cell.y = floor(sortedParticles[indexOffset+1] / state->cellSize);
@@ -168,7 +355,7 @@ void LennardJones::getAcceleration(int index, double* sortedParticles, double* p
 
 				hash = cRef.x + (scale * cRef.y) + (cellScaleSq * cRef.z);
 
-				type3<double> result = iterCells(index, hash, sortedParticles, cellStartEnd, state);
+				type3<double> result = iterCells(index, species, hash, sortedParticles, cellStartEnd, state);
 				netForce[0] += result.x;
 				netForce[1] += result.y;
 				netForce[2] += result.z;
@@ -176,6 +363,14 @@ void LennardJones::getAcceleration(int index, double* sortedParticles, double* p
 		}
 	}
 
+	if (useSPME)
+	{
+		const double* recip = pme->getForce(index);
+		netForce[0] += recip[0];
+		netForce[1] += recip[1];
+		netForce[2] += recip[2];
+	}
+
 	particleForce[realIndex] = netForce[0];
 	particleForce[realIndex+1] = netForce[1];
 	particleForce[realIndex+2] = netForce[2];